@@ -0,0 +1,973 @@
+/* benchmark.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+/*
+	Micro-benchmarks of the parser kernels for the host replay driver (option -b).
+	Every benchmark verifies first that the optimized kernel gives the same results
+	as the reference implementation and fails otherwise.
+*/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "encoder.h"
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+typedef decltype(frameState) FrameState;
+
+volatile uint32_t benchmarkSink = 0;
+
+template<typename Function>
+static double measureNs(int iterations, Function&& function)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+		function();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / (double)iterations;
+}
+
+/**
+ * @brief Fletcher checksums: byte-wise addFletcher vs the span kernel
+ *
+ * @return true if both versions are identical
+ */
+static bool benchmarkFletcher(unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<uint8_t> data(4 * 4096 + 4);
+
+	// equivalence: random lengths, random split points, all 0xff to stress the accumulators
+	for (int test = 0; test < 2000; test++)
+	{
+		FrameState byteWise, spanWise;
+		int len = rng() % data.size();
+		bool saturated = (test % 10) == 0;
+
+		for (auto& a : data)
+			a = (saturated) ? 0xff : (uint8_t)rng();
+
+		byteWise.init(rng());
+		spanWise = byteWise;
+
+		for (int i = 0; i < len; i++)
+			byteWise.addFletcher(data[i]);
+
+		for (int i = 0; i < len;)
+		{
+			int span = std::min(len - i, (int)(rng() % 9000));
+			spanWise.addFletcher(&data[i], span);
+			i += span;
+		}
+
+		if (byteWise.getFletcher1() != spanWise.getFletcher1() || byteWise.getFletcher2() != spanWise.getFletcher2() ||
+			byteWise.getFletcherExt() != spanWise.getFletcherExt())
+		{
+			printf("Fletcher mismatch, length: %i (expected: %02x %02x %02x, got: %02x %02x %02x)\n", len,
+				byteWise.getFletcher1(), byteWise.getFletcher2(), byteWise.getFletcherExt(),
+				spanWise.getFletcher1(), spanWise.getFletcher2(), spanWise.getFletcherExt());
+			return false;
+		}
+	}
+	printf("Fletcher: byte-wise and span kernel are identical\n");
+
+	// throughput: payload of the 900 RGB leds frame
+	const int len = 900 * 3;
+	const int iterations = 20000;
+	FrameState state;
+
+	for (auto& a : data)
+		a = (uint8_t)rng();
+
+	double byteWiseNs = measureNs(iterations, [&]() {
+		state.init(0);
+		for (int i = 0; i < len; i++)
+			state.addFletcher(data[i]);
+		benchmarkSink += state.getFletcherExt();
+	});
+
+	double spanNs = measureNs(iterations, [&]() {
+		state.init(0);
+		state.addFletcher(&data[0], len);
+		benchmarkSink += state.getFletcherExt();
+	});
+
+	printf("Fletcher (%i bytes): byte-wise %.3f ns/byte, span kernel %.3f ns/byte, speedup x%.2f\n",
+		len, byteWiseNs / len, spanNs / len, byteWiseNs / spanNs);
+	return true;
+}
+
+/**
+ * @brief Reference: the previous encoder of NeopixelParallelType (LUT nibbles OR-ed into the cleared buffer)
+ *
+ */
+template<typename colorData>
+struct LutLaneEncoder
+{
+	uint32_t lut[8][16];
+
+	LutLaneEncoder()
+	{
+		for (uint8_t lane = 0; lane < 8; lane++)
+			for (uint8_t a = 0; a < 16; a++)
+			{
+				uint8_t* target = reinterpret_cast<uint8_t*>(&(lut[lane][a]));
+				for (uint8_t b = 0; b < 4; b++)
+					*(target++) = (uint8_t) ((a & (0b00000001 << b)) ? (1 << lane) : 0);
+			}
+	}
+
+	void SetPixel(uint8_t* buffer, int lane, int index, colorData color)
+	{
+		uint8_t* source = reinterpret_cast<uint8_t*>(&color);
+		uint32_t* target = reinterpret_cast<uint32_t*>(&(buffer[(index + 1) * 8 * sizeof(colorData)]));
+
+		for(int i = 0; i < sizeof(colorData); i++)
+		{
+			*(--target) |= lut[lane][ *(source) & 0b00001111];
+			*(--target) |= lut[lane][ *(source++) >> 4];
+		}
+	}
+};
+
+/**
+ * @brief Parallel lanes encoding: the reference LUT encoder vs the transposing encoder of NeopixelParallelType
+ *
+ * @return true if both encoders are identical
+ */
+template<typename Lane, typename colorData>
+static bool benchmarkLaneEncoder(const char* name, std::mt19937& rng)
+{
+	const int leds = 900;
+	const int lanes = 8;
+	const int iterations = 200;
+	const size_t size = leds * 8 * sizeof(colorData);
+	std::vector<colorData> pixels(leds * lanes);
+	std::vector<uint8_t> reference(size);
+	LutLaneEncoder<colorData> lutEncoder;
+	Lane* strips[lanes];
+
+	for (auto& pixel : pixels)
+		for (int i = 0; i < sizeof(colorData); i++)
+			reinterpret_cast<uint8_t*>(&pixel)[i] = (uint8_t)rng();
+
+	for (int lane = 0; lane < lanes; lane++)
+		strips[lane] = new Lane(leds - ((lane == lanes - 1) ? 100 : 0), 2);
+
+	// equivalence: the real render path (lanes of different length) vs the reference
+	for (int lane = 0; lane < lanes; lane++)
+		for (int i = 0; i < leds - ((lane == lanes - 1) ? 100 : 0); i++)
+		{
+			strips[lane]->SetPixel(i, pixels[lane * leds + i]);
+			lutEncoder.SetPixel(reference.data(), lane, i, pixels[lane * leds + i]);
+		}
+
+	strips[0]->renderAllLanes();
+
+	if (shim::lastDmaChannel < 0 || shim::dmaChannels[shim::lastDmaChannel].lastTransfer != reference)
+	{
+		printf("Lanes encoder (%s): mismatch with the reference LUT encoder\n", name);
+		return false;
+	}
+	printf("Lanes encoder (%s): LUT and transposing encoder are identical\n", name);
+
+	// throughput: compose 8 lanes and encode them
+	std::vector<uint8_t> staging(size), target(size);
+
+	double lutNs = measureNs(iterations, [&]() {
+		memset(reference.data(), 0, size);
+		for (int lane = 0; lane < lanes; lane++)
+			for (int i = 0; i < leds; i++)
+				lutEncoder.SetPixel(reference.data(), lane, i, pixels[lane * leds + i]);
+		benchmarkSink += reference[size / 2];
+	});
+
+	double transposeNs = measureNs(iterations, [&]() {
+		for (int lane = 0; lane < lanes; lane++)
+			for (int i = 0; i < leds; i++)
+			{
+				uint8_t* source = reinterpret_cast<uint8_t*>(&pixels[lane * leds + i]);
+				for (int k = 0; k < sizeof(colorData); k++)
+					staging[(i * sizeof(colorData) + k) * 8 + lane] = source[k];
+			}
+		Lane::encodeLanes(staging.data(), target.data());
+		benchmarkSink += target[size / 2];
+	});
+
+	// the base of the delta frame is restored from the sent bitplanes
+	std::vector<uint8_t> decoded(size);
+	Lane::decodeLanes(target.data(), decoded.data());
+
+	for (int lane = lanes - 1; lane >= 0; lane--)
+		delete strips[lane];
+
+	if (decoded != staging)
+	{
+		printf("Lanes decoder (%s): the decoded lane bytes differ from the encoded ones\n", name);
+		return false;
+	}
+
+	printf("Lanes encoder (%s, %i lanes x %i leds): LUT %.2f ns/pixel, transposing %.2f ns/pixel, speedup x%.2f\n",
+		name, lanes, leds, lutNs / (lanes * leds), transposeNs / (lanes * leds), lutNs / transposeNs);
+	return true;
+}
+
+/**
+ * @brief Interpolation: the SWAR blend kernel vs the byte-wise reference for every weight
+ *
+ * @return true if both versions are identical
+ */
+static bool benchmarkBlend(unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	const int leds = 900;
+	const int iterations = 2000;
+	std::vector<ColorDefinition> from(leds), to(leds), target(leds);
+
+	for (auto frame : { &from, &to })
+		for (auto& color : *frame)
+			for (size_t i = 0; i < sizeof(ColorDefinition); i++)
+				reinterpret_cast<uint8_t*>(&color)[i] = (uint8_t)rng();
+
+	for (uint32_t weight = 0; weight <= 256; weight++)
+		for (int i = 0; i < leds; i++)
+		{
+			ColorDefinition blend = blendColor(from[i], to[i], weight);
+
+			for (size_t k = 0; k < sizeof(ColorDefinition); k++)
+			{
+				uint8_t a = reinterpret_cast<uint8_t*>(&from[i])[k], b = reinterpret_cast<uint8_t*>(&to[i])[k];
+
+				if (reinterpret_cast<uint8_t*>(&blend)[k] != (uint8_t)((a * (256 - weight) + b * weight) >> 8))
+				{
+					printf("Blend mismatch, weight: %u, a: %02x, b: %02x\n", weight, a, b);
+					return false;
+				}
+			}
+		}
+	printf("Blend: the kernel and the byte-wise reference are identical\n");
+
+	double blendNs = measureNs(iterations, [&]() {
+		uint32_t weight = rng() % 257;
+		for (int i = 0; i < leds; i++)
+			target[i] = blendColor(from[i], to[i], weight);
+		benchmarkSink += reinterpret_cast<uint8_t*>(&target[leds / 2])[0];
+	});
+
+	printf("Blend (%i leds, %zu bytes/color): %.2f ns/pixel\n", leds, sizeof(ColorDefinition), blendNs / leds);
+	return true;
+}
+
+#if defined(DITHERING_RENDER)
+	/**
+	 * @brief Temporal dithering: the average of the output over 256 frames must be exactly the 8.8 input value,
+	 *        the high precision RGBW conversion must match rgb2rgbw for the 8-bit colors.
+	 *        Reports the cost of the dither kernel per pixel and the LED count that it can re-render at the given rate.
+	 *
+	 * @return true if the kernel is exact
+	 */
+	static bool benchmarkDither(unsigned int seed)
+	{
+		std::mt19937 rng(seed);
+
+		for (uint32_t value = 0; value <= 0xff00; value++)
+		{
+			uint8_t error = 0;
+			uint32_t sum = 0;
+
+			for (int i = 0; i < 256; i++)
+				sum += ditherChannel(value, error);
+
+			if (sum != value)
+			{
+				printf("Dither mismatch, value: %04x, average: %u/256\n", value, sum);
+				return false;
+			}
+		}
+		printf("Dither: the average of 256 frames is exact for every 8.8 value\n");
+
+		#if defined(NEOPIXEL_RGBW)
+			for (int i = 0; i < 100000; i++)
+			{
+				uint8_t r = rng(), g = rng(), b = rng();
+
+				frameState.color.R = r;
+				frameState.color.G = g;
+				frameState.color.B = b;
+				frameState.rgb2rgbw();
+
+				frameState.highPrecisionColor = { (uint16_t)(r << 8), (uint16_t)(g << 8), (uint16_t)(b << 8), 0 };
+				frameState.rgb2rgbwHighPrecision();
+
+				ColorHighPrecision& color = frameState.highPrecisionColor;
+				if (color.R != frameState.color.R << 8 || color.G != frameState.color.G << 8 ||
+					color.B != frameState.color.B << 8 || color.W != frameState.color.W << 8)
+				{
+					printf("Dither: high precision RGBW mismatch for %02x%02x%02x\n", r, g, b);
+					return false;
+				}
+			}
+			printf("Dither: the high precision RGBW conversion matches rgb2rgbw\n");
+		#endif
+
+		const int leds = 900;
+		const int iterations = 2000;
+		std::vector<ColorHighPrecision> frame(leds);
+		std::vector<ColorDitheringError> errors(leds);
+		std::vector<ColorDefinition> target(leds);
+
+		for (auto& color : frame)
+			for (size_t i = 0; i < sizeof(ColorHighPrecision) / 2; i++)
+				reinterpret_cast<uint16_t*>(&color)[i] = (uint16_t)rng();
+
+		auto kernel = [&]() {
+			for (int i = 0; i < leds; i++)
+				target[i] = ditherColor(frame[i], errors[i]);
+			benchmarkSink += target[leds / 2].R;
+		};
+
+		double ditherNs = measureNs(iterations, kernel) / leds;
+
+		double cycles = 0;
+
+		#if defined(__x86_64__) || defined(__i386__)
+			uint64_t start = __rdtsc();
+			for (int i = 0; i < iterations; i++)
+				kernel();
+			cycles = (__rdtsc() - start) / (double)iterations / leds;
+		#endif
+
+		printf("Dither (%i leds, %zu channels): %.2f ns/pixel, %.1f TSC cycles/pixel\n", leds, sizeof(ColorHighPrecision) / 2,
+			ditherNs, cycles);
+
+		// the LED count at which the kernel alone takes the whole output period
+		for (int rate : { 100, 200, 400 })
+			printf("Dither at %i Hz: keeps up with %.0f leds on the host, %.0f leds on a 133 MHz core with the same cycles/pixel\n",
+				rate, 1e9 / rate / ditherNs, (cycles > 0) ? 133e6 / rate / cycles : 0.0);
+
+		return true;
+	}
+#endif
+
+/**
+ * @brief Read the full frames (protocol version 1, 2 or 3) of the recorded AWA stream
+ *
+ * @param input
+ * @param frames pixels of every frame, the frames must have the same size as the first one
+ * @param pixelSize
+ * @return true if any frame was found
+ */
+static bool readRecordedFrames(const char* input, std::vector<std::vector<uint8_t>>& frames, int& pixelSize)
+{
+	std::vector<uint8_t> data;
+	FILE* file = fopen(input, "rb");
+
+	if (file == nullptr)
+		return false;
+
+	uint8_t chunk[4096];
+	size_t received;
+	while ((received = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		data.insert(data.end(), chunk, chunk + received);
+	fclose(file);
+
+	for (size_t i = 0; i + 6 <= data.size();)
+	{
+		bool header = data[i] == 'A' && (data[i + 1] == 'w' || data[i + 1] == 'W') &&
+						(data[i + 2] == 'a' || (data[i + 1] == 'w' && data[i + 2] == 'A')) &&
+						(data[i + 3] ^ data[i + 4] ^ 0x55) == data[i + 5];
+		int size = (data[i + 1] == 'W') ? 4 : 3;
+		size_t length = ((data[i + 3] << 8 | data[i + 4]) + 1) * size;
+		size_t trailer = ((data[i + 2] == 'A') ? 4 : 0) + 3;
+
+		if (!header || i + 6 + length + trailer > data.size() ||
+			(!frames.empty() && (size != pixelSize || length != frames[0].size())))
+		{
+			i++;
+			continue;
+		}
+
+		pixelSize = size;
+		frames.emplace_back(data.begin() + i + 6, data.begin() + i + 6 + length);
+		i += 6 + length + trailer;
+	}
+
+	return !frames.empty();
+}
+
+/**
+ * @brief Feed the stream to the parser in the USB packets and measure the time of the parser
+ *
+ * @param stream
+ * @return parser time in ns
+ */
+static double feedParser(const std::vector<uint8_t>& stream)
+{
+	double time = 0;
+
+	for (size_t position = 0; position < stream.size();)
+	{
+		size_t received = std::min(stream.size() - position, (size_t)64);
+
+		base.ring.write(&stream[position], received);
+		position += received;
+
+		shim::runAlarms();
+		time += measureNs(1, []() { processData(); });
+	}
+
+	#if defined(INTERPOLATION_RENDER)
+		// let the last transition finish
+		busy_wait_us(INTERPOLATION_MAX_TIME + INTERPOLATION_PERIOD);
+		processData();
+	#elif defined(RENDER_SCHEDULER)
+		// let the scheduler submit the last frame
+		busy_wait_us(100000);
+	#else
+		// the last frame could wait for the latch alarm
+		busy_wait_us(1000);
+	#endif
+
+	return time;
+}
+
+/**
+ * @brief Capture the last transfer of every DMA channel that sends the frame
+ *
+ * @return std::vector<std::vector<uint8_t>>
+ */
+static std::vector<std::vector<uint8_t>> captureStrip()
+{
+	std::vector<std::vector<uint8_t>> channels;
+
+	for (int channel = 0; channel < NUM_DMA_CHANNELS; channel++)
+		if (shim::frameChannels & (1u << channel))
+			channels.push_back(shim::dmaChannels[channel].lastTransfer);
+
+	return channels;
+}
+
+/**
+ * @brief Color LUT: the frames decoded with the uploaded tables must give the same strip
+ *        as the frames corrected by the host. Reports the decoding cost with and without the tables.
+ *
+ * @return true if both strips are identical
+ */
+static bool benchmarkColorLut(unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	const int leds = 900;
+	const int frames = 100;
+	std::vector<uint8_t> tables = makeGammaLut(2.2, { 1.0, 0.9, 0.8 }), identity;
+	std::vector<uint8_t> raw, corrected, upload, reset;
+
+	for (int i = 0; i < COLOR_LUT_SIZE; i++)
+		identity.push_back(i % 256);
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		std::vector<uint8_t> pixels(leds * 3), mapped(leds * 3);
+
+		for (int i = 0; i < leds * 3; i++)
+		{
+			pixels[i] = (uint8_t)rng();
+			mapped[i] = tables[(i % 3) * 256 + pixels[i]];
+		}
+
+		for (auto target : { std::make_pair(&raw, &pixels), std::make_pair(&corrected, &mapped) })
+		{
+			FletcherWriter writer(*target.first);
+			appendAwaHeader(*target.first, 3, 'a', leds);
+			writer.add(target.second->data(), target.second->size());
+			writer.finish();
+		}
+	}
+
+	appendColorLutFrame(upload, tables);
+	appendColorLutFrame(reset, identity);
+
+	feedParser(reset);
+	double plainNs = feedParser(corrected);
+	auto reference = captureStrip();
+
+	feedParser(upload);
+	bool enabled = colorLut.isEnabled();
+	double lutNs = feedParser(raw);
+	auto strip = captureStrip();
+
+	feedParser(reset);
+
+	if (!enabled || colorLut.isEnabled() || strip != reference)
+	{
+		printf("Color LUT: the frames decoded with the tables differ from the corrected frames\n");
+		return false;
+	}
+	printf("Color LUT: the tables give the same strip as the frames corrected by the host\n");
+
+	double pixels = (double)frames * leds;
+
+	printf("Color LUT decoding (%i frames x %i leds): identity %.2f ns/pixel, tables %.2f ns/pixel\n", frames, leds,
+		plainNs / pixels, lutNs / pixels);
+	return true;
+}
+
+/**
+ * @brief Compressed frames: compression ratio of the recorded stream (or the synthetic one with the ambilight-like
+ *        runs of the same colors) and the decoding cost compared to the raw frames
+ *
+ * @return true if the compressed frames give the same strip as the raw frames
+ */
+static bool benchmarkCompression(unsigned int seed, const char* input)
+{
+	std::mt19937 rng(seed);
+	std::vector<std::vector<uint8_t>> frames;
+	std::vector<uint8_t> raw, compressed;
+	int pixelSize = 3;
+
+	if (input != nullptr)
+	{
+		if (!readRecordedFrames(input, frames, pixelSize))
+		{
+			printf("Compression: no AWA frames found in: %s\n", input);
+			return false;
+		}
+	}
+	else
+	{
+		// the edges of the screen: runs of the scene colors with some noise, the scene changes every 50 frames
+		const int leds = 900;
+		std::vector<uint8_t> scene(16 * 3);
+
+		for (int frame = 0; frame < 300; frame++)
+		{
+			if (frame % 50 == 0)
+				for (auto& a : scene)
+					a = (uint8_t)rng();
+
+			frames.emplace_back();
+			while ((int)frames.back().size() < leds * 3)
+			{
+				int run = std::min(1 + (int)(rng() % 24), leds - (int)frames.back().size() / 3);
+				int index = rng() % 16;
+				bool noise = (rng() % 8) == 0;
+
+				for (int i = 0; i < run; i++)
+					for (int k = 0; k < 3; k++)
+						frames.back().push_back((noise) ? (uint8_t)rng() : scene[index * 3 + k]);
+			}
+		}
+	}
+
+	#if !defined(NEOPIXEL_RGBW) && !defined(SPILED_APA102)
+		if (pixelSize == 4)
+		{
+			printf("Compression: 4-byte pixels are not supported by this LED driver\n");
+			return true;
+		}
+	#endif
+
+	const int leds = frames[0].size() / pixelSize;
+
+	for (auto& frame : frames)
+	{
+		FletcherWriter writer(raw);
+		appendAwaHeader(raw, pixelSize, 'a', leds);
+		writer.add(frame.data(), frame.size());
+		writer.finish();
+
+		appendCompressedFrame(compressed, frame, pixelSize);
+	}
+
+	uint64_t rendered = shim::renderedFrames();
+	double rawNs = feedParser(raw);
+	auto rawStrip = captureStrip();
+	uint64_t rawFrames = shim::renderedFrames() - rendered;
+
+	rendered = shim::renderedFrames();
+	double compressedNs = feedParser(compressed);
+	uint64_t compressedFrames = shim::renderedFrames() - rendered;
+
+	#if defined(INTERPOLATION_RENDER) || defined(RENDER_SCHEDULER)
+		// the output rate doesn't follow the input frames, the scheduler drops the frames that come too fast
+		rawFrames = compressedFrames = frames.size();
+	#endif
+
+	if (rawFrames != frames.size() || compressedFrames != frames.size() || captureStrip() != rawStrip)
+	{
+		printf("Compression: the compressed frames differ from the raw frames (rendered: %llu and %llu of %zu)\n",
+			(unsigned long long)rawFrames, (unsigned long long)compressedFrames, frames.size());
+		return false;
+	}
+	printf("Compression: the compressed and raw frames give the same strip\n");
+
+	double pixels = (double)frames.size() * leds;
+
+	printf("Compression (%s, %zu frames x %i leds): %zu -> %zu bytes, ratio %.3f, %.2f bytes/frame\n",
+		(input != nullptr) ? input : "synthetic", frames.size(), leds, raw.size(), compressed.size(),
+		compressed.size() / (double)raw.size(), compressed.size() / (double)frames.size());
+	printf("Compression decoding: raw %.2f ns/pixel, compressed %.2f ns/pixel\n", rawNs / pixels, compressedNs / pixels);
+	return true;
+}
+
+/**
+ * @brief Header resync: the word-at-a-time search vs the byte-wise one,
+ *        then the frames separated by the noise bursts with the fake headers go through the parser
+ *
+ * @return true if every frame was recovered and every discarded byte was counted
+ */
+static bool benchmarkResync(unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<uint8_t> data(64 * 1024 + 8);
+
+	// equivalence: random density of 'A', random start and end (alignment)
+	for (int test = 0; test < 2000; test++)
+	{
+		uint32_t density = 1 + rng() % 512;
+
+		for (auto& a : data)
+			a = (rng() % density == 0) ? 'A' : (uint8_t)rng();
+
+		uint32_t length = rng() % data.size();
+		uint32_t position = (length > 0) ? rng() % length : 0;
+		uint32_t expected = std::find(data.begin() + position, data.begin() + length, 'A') - data.begin();
+
+		if (findHeaderStart(data.data(), position, length) != expected)
+		{
+			printf("Resync search: mismatch at %u of %u (expected: %u)\n", position, length, expected);
+			return false;
+		}
+	}
+	printf("Resync search: byte-wise and word-at-a-time search are identical\n");
+
+	// throughput: the noise without any 'A'
+	for (auto& a : data)
+		a = (uint8_t)(rng() % 255);
+	for (auto& a : data)
+		a = (a == 'A') ? 0xff : a;
+
+	const int iterations = 2000;
+	double byteWiseNs = measureNs(iterations, [&]() {
+		benchmarkSink += std::find(data.begin(), data.end(), 'A') - data.begin();
+	});
+
+	double wordNs = measureNs(iterations, [&]() {
+		benchmarkSink += findHeaderStart(data.data(), 0, data.size());
+	});
+
+	printf("Resync search (%zu bytes): byte-wise %.3f ns/byte, word-at-a-time %.3f ns/byte, speedup x%.2f\n",
+		data.size(), byteWiseNs / data.size(), wordNs / data.size(), byteWiseNs / wordNs);
+
+	// parser: the noise bursts between the frames, the fake headers have the wrong CRC, unknown variant or control command
+	const int leds = 900, frames = 100;
+	std::vector<uint8_t> clean, noisy;
+	uint32_t noiseBytes = 0, resyncBytes = 0, maxBurst = 0;
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		std::vector<uint8_t> pixels(leds * 3);
+		for (auto& a : pixels)
+			a = (uint8_t)rng();
+
+		for (auto stream : { &clean, &noisy })
+		{
+			FletcherWriter writer(*stream);
+			appendAwaHeader(*stream, 3, 'a', leds);
+			writer.add(pixels.data(), pixels.size());
+			writer.finish();
+		}
+
+		uint32_t burst = 1 + rng() % 4096;
+		for (uint32_t i = 0; i < burst; i++)
+		{
+			uint8_t a = (uint8_t)rng();
+			noisy.push_back((a != 'A') ? a : 0xff);
+		}
+
+		for (int i = rng() % 4; i > 0; i--)
+		{
+			appendAwaHeader(noisy, 3, 'a', 1 + rng() % leds);
+
+			if (i == 1)
+				noisy[noisy.size() - 4] = 'x';
+			else if (i == 2)
+			{
+				noisy.resize(noisy.size() - 3);
+				noisy.insert(noisy.end(), { 0x2a, 0xa2, 0x05 });
+			}
+			else
+				noisy.back() ^= 1 + rng() % 255;
+
+			burst += 6;
+		}
+
+		noiseBytes += burst;
+
+		// every discarded byte is counted: the scanner and the state machine (the headers split by the chunks)
+		if (frame + 1 < frames)
+		{
+			resyncBytes += burst;
+			maxBurst = std::max(maxBurst, burst);
+		}
+	}
+
+	statistics.reset(millis());
+
+	uint64_t rendered = shim::renderedFrames();
+	double cleanNs = feedParser(clean);
+	uint64_t cleanFrames = shim::renderedFrames() - rendered;
+
+	rendered = shim::renderedFrames();
+	double noisyNs = feedParser(noisy);
+	uint64_t noisyFrames = shim::renderedFrames() - rendered;
+
+	#if defined(INTERPOLATION_RENDER) || defined(RENDER_SCHEDULER)
+		// the output rate doesn't follow the input frames
+		cleanFrames = noisyFrames = frames;
+	#endif
+
+	// the burst after the last frame waits for the next header
+	if (cleanFrames != frames || noisyFrames != frames || statistics.getResyncs() != frames - 1 ||
+		statistics.getResyncBytes() != resyncBytes / (frames - 1) || statistics.getResyncMaxBytes() != maxBurst)
+	{
+		printf("Resync: frames lost (rendered: %llu and %llu of %i, resyncs: %u, discarded bytes/resync: %u of %u, max: %u of %u)\n",
+			(unsigned long long)cleanFrames, (unsigned long long)noisyFrames, frames, statistics.getResyncs(),
+			statistics.getResyncBytes(), resyncBytes / (frames - 1), statistics.getResyncMaxBytes(), maxBurst);
+		return false;
+	}
+
+	printf("Resync (%i frames x %i leds, %u noise bytes): %u resyncs, %u bytes/resync, max %u, time/resync: %u us\n",
+		frames, leds, noiseBytes, statistics.getResyncs(), statistics.getResyncBytes(), statistics.getResyncMaxBytes(),
+		statistics.getResyncTime());
+	printf("Resync parser: clean stream %.2f ns/byte, noisy stream %.2f ns/byte\n", cleanNs / clean.size(), noisyNs / noisy.size());
+	return true;
+}
+
+/**
+ * @brief The byte of the ring stress stream at the position
+ *
+ */
+static inline uint8_t ringPattern(uint64_t position)
+{
+	return (uint8_t)(position ^ (position >> 8) ^ (position >> 19));
+}
+
+/**
+ * @brief Ring buffer: the producer and the consumer run in two threads like core0 and core1.
+ *        Random span sizes and both read paths (spans and single bytes) must deliver the stream intact.
+ *        Then the overflow: the bytes that don't fit are dropped and counted, the unread data is kept.
+ *
+ * @return true if no byte was lost, reordered or overwritten
+ */
+static bool benchmarkRing(unsigned int seed)
+{
+	// odd size: the spans end at every position of the ring
+	static RingBuffer<1021> ring;
+	const uint64_t total = 64ull << 20;
+	uint64_t received = 0, mismatch = UINT64_MAX;
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::thread producer([&]() {
+		std::mt19937 rng(seed);
+		uint64_t sent = 0;
+
+		while (sent < total)
+		{
+			uint32_t span;
+			uint8_t* target = ring.getWriteSpan(span);
+
+			span = (uint32_t)std::min<uint64_t>(std::min(span, (uint32_t)(rng() % 600 + 1)), total - sent);
+			if (span == 0)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			for (uint32_t i = 0; i < span; i++)
+				target[i] = ringPattern(sent + i);
+
+			ring.commitWrite(span);
+			sent += span;
+		}
+	});
+
+	std::mt19937 rng(seed + 1);
+	while (received < total && mismatch == UINT64_MAX)
+	{
+		if (ring.isEmpty())
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		if (rng() % 4 == 0)
+		{
+			if (ring.pop() != ringPattern(received))
+				mismatch = received;
+			received++;
+		}
+		else
+		{
+			uint32_t span;
+			const uint8_t* source = ring.getReadSpan(span);
+
+			span = std::min(span, (uint32_t)(rng() % 900 + 1));
+			for (uint32_t i = 0; i < span && mismatch == UINT64_MAX; i++)
+				if (source[i] != ringPattern(received + i))
+					mismatch = received + i;
+
+			ring.consume(span);
+			received += span;
+		}
+	}
+
+	if (mismatch != UINT64_MAX)
+	{
+		// let the producer finish
+		while (received < total)
+		{
+			uint32_t span;
+			ring.getReadSpan(span);
+			ring.consume(span);
+			received += span;
+		}
+	}
+	producer.join();
+
+	double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / 1e9;
+
+	if (mismatch != UINT64_MAX)
+	{
+		printf("Ring buffer: the stream is broken at byte %llu\n", (unsigned long long)mismatch);
+		return false;
+	}
+	printf("Ring buffer: two threads passed %llu MB intact, %.1f MB/s\n", (unsigned long long)(total >> 20), (total >> 20) / seconds);
+
+	// overflow: fill the ring over its capacity
+	std::vector<uint8_t> data(ring.capacity() + 100);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = ringPattern(i);
+
+	uint32_t dropped = ring.getDropped();
+	uint32_t written = ring.write(data.data(), data.size());
+	uint32_t span;
+
+	bool intact = (written == ring.capacity() && ring.getDropped() - dropped == 100 && ring.write(data.data(), 1) == 0);
+	for (uint64_t position = 0; intact && !ring.isEmpty(); ring.consume(span))
+	{
+		const uint8_t* source = ring.getReadSpan(span);
+		for (uint32_t i = 0; i < span; i++, position++)
+			intact = intact && (source[i] == ringPattern(position));
+	}
+
+	if (!intact)
+	{
+		printf("Ring buffer: the overflow wasn't detected or it damaged the unread data\n");
+		return false;
+	}
+	printf("Ring buffer: the overflow dropped and counted %u bytes, the unread data is intact\n", ring.getDropped() - dropped);
+	return true;
+}
+
+/**
+ * @brief Run the benchmark selected by the name
+ *
+ * @return process exit code
+ */
+static int runBenchmark(const char* name, unsigned int seed, const char* input)
+{
+	bool all = strcmp(name, "all") == 0;
+	bool result = true, found = false;
+
+	if (all || strcmp(name, "fletcher") == 0)
+	{
+		found = true;
+		result = benchmarkFletcher(seed) && result;
+	}
+
+	if (all || strcmp(name, "lanes") == 0)
+	{
+		std::mt19937 rng(seed);
+		found = true;
+		result = benchmarkLaneEncoder<sk6812p, ColorGrbw>("sk6812p", rng) && result;
+		result = benchmarkLaneEncoder<ws2812p, ColorGrb>("ws2812p", rng) && result;
+	}
+
+	if (all || strcmp(name, "blend") == 0)
+	{
+		found = true;
+		result = benchmarkBlend(seed) && result;
+	}
+
+	#if defined(DITHERING_RENDER)
+		if (all || strcmp(name, "dither") == 0)
+		{
+			found = true;
+			result = benchmarkDither(seed) && result;
+		}
+	#endif
+
+	if (all || strcmp(name, "lut") == 0)
+	{
+		found = true;
+		result = benchmarkColorLut(seed) && result;
+	}
+
+	if (all || strcmp(name, "compress") == 0)
+	{
+		found = true;
+		result = benchmarkCompression(seed, input) && result;
+	}
+
+	if (all || strcmp(name, "resync") == 0)
+	{
+		found = true;
+		result = benchmarkResync(seed) && result;
+	}
+
+	if (all || strcmp(name, "ring") == 0)
+	{
+		found = true;
+		result = benchmarkRing(seed) && result;
+	}
+
+	if (!found)
+	{
+		fprintf(stderr, "Unknown benchmark: %s\n", name);
+		return 1;
+	}
+
+	return (result) ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,326 @@
+/* encoder.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+/*
+	Sender side of the AWA protocol for the host replay driver and the benchmarks:
+	Fletcher checksums, the compressed frame encoder (runs of the same color, the per-frame palette),
+	the high precision frames (16-bit channels) and the corruption patterns of the degraded streams.
+*/
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+/**
+ * @brief Fletcher checksums of the frame payload like the AWA sender computes them
+ *
+ */
+struct FletcherWriter
+{
+	std::vector<uint8_t>& stream;
+	uint16_t fletcher1 = 0, fletcher2 = 0, fletcherExt = 0;
+	uint8_t position = 0;
+
+	FletcherWriter(std::vector<uint8_t>& _stream) : stream(_stream)
+	{
+	}
+
+	void add(uint8_t input)
+	{
+		stream.push_back(input);
+		fletcher1 = (fletcher1 + (uint16_t)input) % 255;
+		fletcher2 = (fletcher2 + fletcher1) % 255;
+		fletcherExt = (fletcherExt + (input ^ (position++))) % 255;
+	}
+
+	void add(const uint8_t* input, int len)
+	{
+		for (; len > 0; len--)
+			add(*(input++));
+	}
+
+	void finish()
+	{
+		stream.push_back(fletcher1);
+		stream.push_back(fletcher2);
+		stream.push_back((fletcherExt != 0x41) ? fletcherExt : 0xaa);
+	}
+};
+
+/**
+ * @brief Append the AWA header: 'A', 'w' ('W' for 4-byte pixels), the variant, LED count and CRC
+ *
+ * @param stream
+ * @param pixelSize
+ * @param variant 'a': version 1/3, 'A': version 2, 'd': delta frame, 'c': compressed frame, 'h': high precision frame
+ * @param leds
+ */
+static void appendAwaHeader(std::vector<uint8_t>& stream, int pixelSize, uint8_t variant, int leds)
+{
+	uint16_t count = leds - 1;
+	uint8_t hi = count >> 8, lo = count & 0xff;
+
+	stream.push_back('A');
+	stream.push_back((pixelSize == 4) ? 'W' : 'w');
+	stream.push_back(variant);
+	stream.push_back(hi);
+	stream.push_back(lo);
+	stream.push_back(hi ^ lo ^ 0x55);
+}
+
+/**
+ * @brief Append the compressed frame. Greedy encoder: the runs of the same color become the run tokens,
+ *        the colors that repeat often enough go to the palette and the rest is sent as the literal pixels.
+ *
+ * @param stream
+ * @param pixels the whole frame
+ * @param pixelSize 3 or 4 bytes
+ */
+static void appendCompressedFrame(std::vector<uint8_t>& stream, const std::vector<uint8_t>& pixels, int pixelSize)
+{
+	const int leds = pixels.size() / pixelSize;
+	// a run token costs 1 + pixelSize bytes: the palette indexes are cheaper for the short runs
+	const int minRun = 2, minPaletteRun = pixelSize + 1;
+
+	auto color = [&](int i) {
+		uint32_t value = 0;
+		memcpy(&value, &pixels[i * pixelSize], pixelSize);
+		return value;
+	};
+
+	auto runLength = [&](int i) {
+		int run = 1;
+		while (i + run < leds && color(i + run) == color(i))
+			run++;
+		return run;
+	};
+
+	// palette: the most frequent colors outside the runs, an entry pays off if it's used at least twice
+	std::map<uint32_t, int> counts;
+	std::vector<std::pair<int, uint32_t>> candidates;
+	std::map<uint32_t, int> palette;
+
+	for (int i = 0; i < leds;)
+	{
+		int run = runLength(i);
+		if (run < minRun)
+			counts[color(i)]++;
+		i += run;
+	}
+
+	for (auto& count : counts)
+		if (count.second >= 2)
+			candidates.emplace_back(count.second, count.first);
+
+	std::sort(candidates.rbegin(), candidates.rend());
+	candidates.resize(std::min(candidates.size(), (size_t)COMPRESSED_PALETTE_COLORS));
+
+	appendAwaHeader(stream, pixelSize, 'c', leds);
+
+	FletcherWriter writer(stream);
+
+	writer.add(candidates.size());
+	for (auto& candidate : candidates)
+	{
+		int index = palette.size();
+		palette[candidate.second] = index;
+		writer.add(reinterpret_cast<const uint8_t*>(&candidate.second), pixelSize);
+	}
+
+	auto isRun = [&](int i) {
+		return runLength(i) >= ((palette.count(color(i))) ? minPaletteRun : minRun);
+	};
+
+	for (int i = 0; i < leds;)
+	{
+		if (isRun(i))
+		{
+			for (int left = runLength(i); left > 0;)
+			{
+				int run = std::min(left, 64);
+				writer.add(COMPRESSED_TOKEN_RUN | (run - 1));
+				writer.add(&pixels[i * pixelSize], pixelSize);
+				left -= run;
+				i += run;
+			}
+		}
+		else if (palette.count(color(i)))
+		{
+			int length = 1;
+			while (length < 64 && i + length < leds && palette.count(color(i + length)) && !isRun(i + length))
+				length++;
+
+			writer.add(COMPRESSED_TOKEN_INDEXES | (length - 1));
+			for (; length > 0; length--, i++)
+				writer.add(palette[color(i)]);
+		}
+		else
+		{
+			int length = 1;
+			while (length < 128 && i + length < leds && !palette.count(color(i + length)) && !isRun(i + length))
+				length++;
+
+			writer.add(length - 1);
+			writer.add(&pixels[i * pixelSize], length * pixelSize);
+			i += length;
+		}
+	}
+
+	writer.finish();
+}
+
+/**
+ * @brief Append the high precision frame: every channel has 16 bits (high byte first)
+ *
+ * @param stream
+ * @param pixels the whole frame (3-byte pixels), the high bytes of the channels
+ * @param fraction the low byte of every channel
+ */
+static void appendHighPrecisionFrame(std::vector<uint8_t>& stream, const std::vector<uint8_t>& pixels, uint8_t fraction)
+{
+	FletcherWriter writer(stream);
+
+	appendAwaHeader(stream, 3, 'h', pixels.size() / 3);
+
+	for (uint8_t input : pixels)
+	{
+		writer.add(input);
+		writer.add(fraction);
+	}
+
+	writer.finish();
+}
+
+/**
+ * @brief Append the color LUT control frame: the red, green and blue tables
+ *
+ * @param stream
+ * @param tables COLOR_LUT_SIZE bytes
+ */
+static void appendColorLutFrame(std::vector<uint8_t>& stream, const std::vector<uint8_t>& tables)
+{
+	FletcherWriter writer(stream);
+
+	stream.insert(stream.end(), { 'A', 'w', 'a', 0x2a, 0xa2, COMMAND_COLOR_LUT });
+	writer.add(tables.data(), tables.size());
+	writer.finish();
+}
+
+/**
+ * @brief Gamma curve with the white balance for the color LUT control frame
+ *
+ * @param gamma
+ * @param balance red, green and blue gain (0-1)
+ * @return std::vector<uint8_t> COLOR_LUT_SIZE bytes
+ */
+static std::vector<uint8_t> makeGammaLut(double gamma, const double (&balance)[COLOR_LUT_CHANNELS])
+{
+	std::vector<uint8_t> tables;
+
+	for (int channel = 0; channel < COLOR_LUT_CHANNELS; channel++)
+		for (int i = 0; i < 256; i++)
+			tables.push_back((uint8_t)std::lround(std::pow(i / 255.0, gamma) * balance[channel] * 255));
+
+	return tables;
+}
+
+/**
+ * @brief Corruption patterns of the degraded streams
+ *
+ */
+enum class Corruption { truncate, bitflip, count, half, embedded, all };
+
+static const char* const corruptionNames[] = { "truncate", "bitflip", "count", "half", "embedded", "all" };
+
+/**
+ * @brief Damage the frame of the stream (header, payload and the Fletcher checksums):
+ *        truncate: the frame ends at a random position, bitflip: one random bit is flipped,
+ *        count: the header has a valid CRC but a wrong LED count, half: only the second half of the frame arrives,
+ *        embedded: the frame is truncated and the next one carries the valid headers in its pixels
+ *        (its checksums are recomputed, so it stays intact)
+ *
+ * @param frame
+ * @param next the next frame (empty if there is none), used only by the embedded pattern
+ * @param pixelBytes size of the pixel payload after the header
+ * @param pattern
+ * @param rng
+ */
+static void corruptFrame(std::vector<uint8_t>& frame, std::vector<uint8_t>& next, int pixelBytes, Corruption pattern, std::mt19937& rng)
+{
+	switch (pattern)
+	{
+	case Corruption::bitflip:
+		frame[rng() % frame.size()] ^= 1 << (rng() % 8);
+		break;
+
+	case Corruption::count:
+	{
+		uint16_t count = (((frame[3] << 8) | frame[4]) + 1 + rng() % 4095) % 4096;
+
+		frame[3] = count >> 8;
+		frame[4] = count & 0xff;
+		frame[5] = frame[3] ^ frame[4] ^ 0x55;
+		break;
+	}
+
+	case Corruption::half:
+		frame.erase(frame.begin(), frame.begin() + frame.size() / 2);
+		break;
+
+	case Corruption::embedded:
+		if (!next.empty())
+		{
+			// the valid headers of the same pixel size with the random LED counts
+			std::vector<uint8_t> header;
+			std::vector<uint8_t> payload(next.begin() + 6, next.end() - 3);
+
+			for (int i = 1 + rng() % 3; i > 0 && pixelBytes >= 6; i--)
+			{
+				header.clear();
+				appendAwaHeader(header, (next[1] == 'W') ? 4 : 3, next[2], 1 + rng() % 4096);
+				std::copy(header.begin(), header.end(), payload.begin() + rng() % (pixelBytes - 5));
+			}
+
+			next.resize(6);
+			FletcherWriter writer(next);
+			writer.add(payload.data(), payload.size());
+			writer.finish();
+		}
+		[[fallthrough]];
+
+	default:
+		frame.resize(1 + rng() % (frame.size() - 1));
+		break;
+	}
+}
+
+#endif
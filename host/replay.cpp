@@ -0,0 +1,1072 @@
+/* replay.cpp
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+/*
+	Host replay driver for the AWA parser.
+	Compiles processData() together with the led drivers against the pico/FreeRTOS shim
+	and feeds it with a recorded stream (file or serial/pty device) or a synthetic one.
+	Reports parsed frames/s, bytes/s and optionally dumps the final strip buffer.
+*/
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <algorithm>
+#include "pico/stdlib.h"
+#include "pico/sem.h"
+#include "leds.h"
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#define _STR(x) #x
+#define _XSTR(x) _STR(x)
+
+#include "leddriver.h"
+
+/////////////////////////////////////////////////////////////////////////
+#define delay(x) sleep_ms(x)
+#define millis xTaskGetTickCount
+
+#include "main.h"
+#include "encoder.h"
+#include "benchmark.h"
+
+struct
+{
+	const char* input = nullptr;
+	const char* output = nullptr;
+	const char* benchmark = nullptr;
+	const char* layout = nullptr;
+	const char* lut = nullptr;
+	const char* corruption = nullptr;
+	int leds = 900;
+	int frames = 1000;
+	int version = 1;
+	int repeat = 1;
+	int updates = 0;
+	int rate = 0;
+	int fraction = -1;
+	int stall = 0;
+	size_t chunk = 64;
+	unsigned int seed = 2023;
+	bool delta = false;
+	bool compressed = false;
+	bool dump = false;
+} options;
+
+struct
+{
+	uint64_t bytes = 0;
+	uint64_t parserTime = 0;
+} replayStats;
+
+// the longest frame that the damaged header can announce: the parser may consume it before it resyncs
+#define CORRUPTION_WINDOW (6 + 4096 * 4 + 4 + 3)
+
+// the degraded stream (-j): the frames damaged on purpose and the intact frames lost because of them
+struct
+{
+	Corruption pattern = Corruption::all;
+	int every = 10;
+	std::vector<bool> damaged;
+	uint64_t errors = 0;
+	uint64_t lostFrames = 0;
+	uint64_t unexplainedLost = 0;
+	uint64_t acceptedDamaged = 0;
+	// the stream of the rejected frame went on while the parser was waiting for the next header
+	uint64_t strayStreams = 0;
+	uint64_t resyncs = 0;
+	uint64_t resyncBytes = 0;
+	uint64_t maxResyncBytes = 0;
+} corruptionStats;
+
+static int pixelSize()
+{
+	return (options.version == 3) ? 4 : 3;
+}
+
+static void appendHeader(std::vector<uint8_t>& stream, uint8_t variant)
+{
+	appendAwaHeader(stream, pixelSize(), variant, options.leds);
+}
+
+/**
+ * @brief Append one AWA frame with all the pixels to the stream
+ *
+ * @param stream
+ * @param pixels
+ */
+static void appendFrame(std::vector<uint8_t>& stream, const std::vector<uint8_t>& pixels)
+{
+	FletcherWriter writer(stream);
+
+	appendHeader(stream, (options.version == 2) ? 'A' : 'a');
+
+	for (uint8_t input : pixels)
+		writer.add(input);
+
+	// version 2: keep the default calibration (gain, red, green, blue)
+	if (options.version == 2)
+	{
+		writer.add(0xFF);
+		writer.add(0xA0);
+		writer.add(0xA0);
+		writer.add(0xA0);
+	}
+
+	writer.finish();
+}
+
+/**
+ * @brief Append the delta frame: only the ranges of the pixels that changed since the previous frame
+ *
+ * @param stream
+ * @param pixels
+ * @param ranges pairs of the first pixel index and the length
+ */
+static void appendDeltaFrame(std::vector<uint8_t>& stream, const std::vector<uint8_t>& pixels,
+							const std::vector<std::pair<int, int>>& ranges)
+{
+	FletcherWriter writer(stream);
+
+	appendHeader(stream, 'd');
+
+	for (auto& range : ranges)
+	{
+		writer.add(range.first >> 8);
+		writer.add(range.first & 0xff);
+		writer.add(range.second >> 8);
+		writer.add(range.second & 0xff);
+
+		for (int i = range.first * pixelSize(); i < (range.first + range.second) * pixelSize(); i++)
+			writer.add(pixels[i]);
+	}
+
+	// the empty range ends the list
+	for (int i = 0; i < 4; i++)
+		writer.add(0);
+
+	writer.finish();
+}
+
+/**
+ * @brief Append the next frame with random colors: all pixels or only the random ranges (-u)
+ *
+ * @param stream
+ * @param pixels the current content of the strip, updated by the frame
+ * @param rng
+ */
+static void appendRandomFrame(std::vector<uint8_t>& stream, std::vector<uint8_t>& pixels, std::mt19937& rng)
+{
+	std::vector<std::pair<int, int>> ranges;
+	bool firstFrame = pixels.empty();
+
+	if (firstFrame || options.updates == 0)
+	{
+		pixels.resize(options.leds * pixelSize());
+
+		for (auto& a : pixels)
+			a = (uint8_t)rng();
+	}
+	else
+	{
+		for (int i = 0; i < options.updates; i++)
+		{
+			int offset = rng() % options.leds;
+			int length = 1 + rng() % std::min(options.leds - offset, std::max(options.leds / 16, 1));
+
+			for (int j = offset * pixelSize(); j < (offset + length) * pixelSize(); j++)
+				pixels[j] = (uint8_t)rng();
+
+			ranges.emplace_back(offset, length);
+		}
+	}
+
+	if (options.delta && !firstFrame && options.updates > 0)
+		appendDeltaFrame(stream, pixels, ranges);
+	else if (options.compressed)
+		appendCompressedFrame(stream, pixels, pixelSize());
+	else if (options.fraction >= 0)
+		appendHighPrecisionFrame(stream, pixels, options.fraction);
+	else
+		appendFrame(stream, pixels);
+}
+
+/**
+ * @brief Append the segments layout control frame to the stream
+ *
+ * @param stream
+ * @param layout starting indexes of the next segments and optional reversed lanes mask: "300,600:5"
+ * @return true if the layout could be parsed
+ */
+static bool appendSegmentsLayout(std::vector<uint8_t>& stream, const char* layout)
+{
+	std::vector<uint8_t> payload(1, 1);
+	uint8_t reversedMask = 0;
+	char* end = const_cast<char*>(layout);
+
+	while (*end != 0 && *end != ':')
+	{
+		unsigned long index = strtoul(end, &end, 10);
+		payload.push_back(index >> 8);
+		payload.push_back(index & 0xff);
+		payload[0]++;
+
+		if (*end == ',')
+			end++;
+		else if (*end != 0 && *end != ':')
+			return false;
+	}
+
+	if (*end == ':')
+		reversedMask = strtoul(end + 1, nullptr, 0);
+
+	payload.push_back(reversedMask);
+
+	uint16_t fletcher1 = 0, fletcher2 = 0, fletcherExt = 0;
+	uint8_t position = 0;
+
+	for (uint8_t input : payload)
+	{
+		fletcher1 = (fletcher1 + (uint16_t)input) % 255;
+		fletcher2 = (fletcher2 + fletcher1) % 255;
+		fletcherExt = (fletcherExt + (input ^ (position++))) % 255;
+	}
+
+	stream.insert(stream.end(), { 'A', 'w', 'a', 0x2a, 0xa2, COMMAND_SEGMENTS_LAYOUT });
+	stream.insert(stream.end(), payload.begin(), payload.end());
+	stream.push_back(fletcher1);
+	stream.push_back(fletcher2);
+	stream.push_back((fletcherExt != 0x41) ? fletcherExt : 0xaa);
+
+	return true;
+}
+
+/**
+ * @brief Append the color LUT control frame to the stream
+ *
+ * @param stream
+ * @param lut gamma and optional white balance of the red, green and blue channels: "2.2:1,0.9,0.8"
+ * @return true if the parameters could be parsed
+ */
+static bool appendColorLut(std::vector<uint8_t>& stream, const char* lut)
+{
+	double balance[COLOR_LUT_CHANNELS] = { 1.0, 1.0, 1.0 };
+	char* end = nullptr;
+	double gamma = strtod(lut, &end);
+
+	for (int channel = 0; channel < COLOR_LUT_CHANNELS && *end == ((channel == 0) ? ':' : ','); channel++)
+		balance[channel] = strtod(end + 1, &end);
+
+	if (*end != 0 || gamma <= 0)
+		return false;
+
+	for (double gain : balance)
+		if (gain < 0 || gain > 1)
+			return false;
+
+	appendColorLutFrame(stream, makeGammaLut(gamma, balance));
+	return true;
+}
+
+/**
+ * @brief Parse the corruption pattern and its period: "truncate:10"
+ *
+ * @param value
+ * @return true if the pattern is known
+ */
+static bool parseCorruption(const char* value)
+{
+	const char* separator = strchr(value, ':');
+	size_t length = (separator != nullptr) ? separator - value : strlen(value);
+
+	if (separator != nullptr)
+		corruptionStats.every = atoi(separator + 1);
+
+	for (int i = 0; i <= (int)Corruption::all; i++)
+		if (strlen(corruptionNames[i]) == length && strncmp(value, corruptionNames[i], length) == 0)
+		{
+			corruptionStats.pattern = (Corruption)i;
+			return corruptionStats.every >= 2;
+		}
+
+	return false;
+}
+
+/**
+ * @brief Damage every n-th frame of the synthetic stream (the first one that can contain the layout and LUT stays intact)
+ *
+ * @param stream
+ * @param frameEnds updated to the damaged frames
+ * @param rng
+ */
+static void corruptStream(std::vector<uint8_t>& stream, std::vector<size_t>& frameEnds, std::mt19937& rng)
+{
+	std::vector<std::vector<uint8_t>> frames;
+	size_t position = 0;
+
+	for (size_t end : frameEnds)
+	{
+		frames.emplace_back(stream.begin() + position, stream.begin() + end);
+		position = end;
+	}
+
+	std::vector<uint8_t> none;
+	// the headers embedded in the delta ranges or compressed tokens would break the frame instead of staying intact
+	int pixelBytes = (options.delta || options.compressed) ? 0 : options.leds * ((options.fraction >= 0) ? 6 : pixelSize());
+
+	corruptionStats.damaged.assign(frames.size(), false);
+	for (size_t i = corruptionStats.every - 1; i < frames.size(); i += corruptionStats.every)
+	{
+		Corruption pattern = corruptionStats.pattern;
+
+		// the delta frames skip the count pattern (see parseArguments)
+		while (pattern == Corruption::all || (options.delta && pattern == Corruption::count))
+			pattern = (Corruption)(rng() % (int)Corruption::all);
+
+		corruptFrame(frames[i], (i + 1 < frames.size()) ? frames[i + 1] : none, pixelBytes, pattern, rng);
+		corruptionStats.damaged[i] = true;
+	}
+
+	stream.clear();
+	frameEnds.clear();
+	for (auto& frame : frames)
+	{
+		stream.insert(stream.end(), frame.begin(), frame.end());
+		frameEnds.push_back(stream.size());
+	}
+}
+
+/**
+ * @brief Count the frames of the degraded stream that were lost and the bytes until the parser recovered.
+ *        The intact frame can be lost only after the damaged one, before the parser accepts a frame again
+ *        and within the longest frame that the damaged header could announce.
+ *
+ * @param frameEnds
+ * @param accepted the frames that passed the checksums
+ */
+static void addCorruptionResults(const std::vector<size_t>& frameEnds, const std::vector<bool>& accepted)
+{
+	const size_t none = SIZE_MAX;
+	size_t errorStart = none;
+
+	auto addResync = [](uint64_t bytes) {
+		corruptionStats.resyncs++;
+		corruptionStats.resyncBytes += bytes;
+		corruptionStats.maxResyncBytes = std::max(corruptionStats.maxResyncBytes, bytes);
+	};
+
+	for (size_t frame = 0; frame < frameEnds.size(); frame++)
+	{
+		size_t start = (frame > 0) ? frameEnds[frame - 1] : 0;
+
+		if (corruptionStats.damaged[frame])
+		{
+			// the next error came before the parser recovered
+			if (errorStart != none)
+				addResync(start - errorStart);
+
+			corruptionStats.errors++;
+			errorStart = start;
+
+			if (accepted[frame])
+				corruptionStats.acceptedDamaged++;
+		}
+		else if (accepted[frame])
+		{
+			if (errorStart != none)
+				addResync(start - errorStart);
+
+			errorStart = none;
+		}
+		else
+		{
+			corruptionStats.lostFrames++;
+
+			if (errorStart == none || start - errorStart > CORRUPTION_WINDOW)
+				corruptionStats.unexplainedLost++;
+		}
+	}
+}
+
+/**
+ * @brief Print the results of the degraded stream
+ *
+ * @return false if a damaged frame was accepted, an intact frame was lost without a reason
+ *         or the stream of the rejected frame continued
+ */
+static bool printCorruptionResults()
+{
+	printf("Corruption (%s, every %i. frame): errors: %llu, lost intact frames: %llu (%.2f/error), unexplained: %llu, accepted damaged frames: %llu\n",
+		corruptionNames[(int)corruptionStats.pattern], corruptionStats.every, (unsigned long long)corruptionStats.errors,
+		(unsigned long long)corruptionStats.lostFrames, corruptionStats.lostFrames / (double)std::max(corruptionStats.errors, (uint64_t)1),
+		(unsigned long long)corruptionStats.unexplainedLost, (unsigned long long)corruptionStats.acceptedDamaged);
+	printf("Corruption recovery: bytes consumed before resync %.0f, max %llu, parser resyncs: %u, discarded bytes/resync: %u, time/resync: %u us\n",
+		corruptionStats.resyncBytes / (double)std::max(corruptionStats.resyncs, (uint64_t)1), (unsigned long long)corruptionStats.maxResyncBytes,
+		(unsigned int)statistics.getResyncs(), (unsigned int)statistics.getResyncBytes(), (unsigned int)statistics.getResyncTime());
+
+	if (corruptionStats.strayStreams > 0)
+		printf("Corruption: the stream of the rejected frame continued %llu times\n", (unsigned long long)corruptionStats.strayStreams);
+
+	return corruptionStats.unexplainedLost == 0 && corruptionStats.acceptedDamaged == 0 && corruptionStats.strayStreams == 0;
+}
+
+// the deferred output goes to stdout like core0 sends it, unless it's captured (telemetry records)
+static std::vector<uint8_t>* logCapture = nullptr;
+
+static void drainLogger()
+{
+	uint32_t length;
+	const uint8_t* data;
+
+	while ((data = logger.getPending(length)), length > 0)
+	{
+		if (logCapture != nullptr)
+			logCapture->insert(logCapture->end(), data, data + length);
+		else
+			fwrite(data, 1, length, stdout);
+
+		logger.consume(length);
+	}
+}
+
+/**
+ * @brief Deliver the data to the ring buffer like the core0 task does and let the parser process it
+ *
+ * @param data
+ * @param len
+ */
+static void feed(const uint8_t* data, size_t len)
+{
+	while (len > 0)
+	{
+		size_t received = std::min(len, options.chunk);
+
+		base.ring.write(data, received);
+		data += received;
+		len -= received;
+
+		// core0: the USB callback, the read and the doorbell
+		base.onUsbCallback();
+		statistics.addUsbReceive(received, false);
+		base.ringDoorbell();
+
+		// the alarms that were due while core1 was waiting for the data
+		shim::runAlarms();
+
+		auto start = std::chrono::steady_clock::now();
+		if (base.waitForDoorbell(0))
+			processData();
+		replayStats.parserTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		replayStats.bytes += received;
+
+		drainLogger();
+	}
+}
+
+/**
+ * @brief Emulate the waiting of core1 for the data: it wakes up periodically to render the interpolated or dithered frames
+ *
+ * @param until
+ */
+static void idle(uint64_t until)
+{
+	while (time_us_64() < until)
+	{
+		#if defined(RENDER_TICK_PERIOD)
+			busy_wait_us(std::min(until - time_us_64(), (uint64_t)RENDER_TICK_PERIOD));
+			processData();
+		#else
+			busy_wait_us(until - time_us_64());
+		#endif
+	}
+}
+
+/**
+ * @brief Stream the data from a serial/pty device until it's closed
+ *
+ * @param fd
+ */
+static void feedFromDevice(int fd)
+{
+	termios tty;
+	if (tcgetattr(fd, &tty) == 0)
+	{
+		cfmakeraw(&tty);
+		tcsetattr(fd, TCSANOW, &tty);
+	}
+
+	std::vector<uint8_t> data(options.chunk);
+	ssize_t received;
+	while ((received = read(fd, data.data(), data.size())) > 0)
+		feed(data.data(), received);
+}
+
+static bool readFile(int fd, std::vector<uint8_t>& stream)
+{
+	uint8_t data[4096];
+	ssize_t received;
+	while ((received = read(fd, data, sizeof(data))) > 0)
+		stream.insert(stream.end(), data, data + received);
+	return received == 0;
+}
+
+static void dumpStripBuffer()
+{
+	if (shim::frameChannels == 0)
+	{
+		printf("Strip buffer: nothing was rendered\n");
+		return;
+	}
+
+	// independent lanes: every lane has own DMA channel
+	for (int channel = 0; channel < NUM_DMA_CHANNELS; channel++)
+	{
+		if (!(shim::frameChannels & (1u << channel)))
+			continue;
+
+		const std::vector<uint8_t>& strip = shim::dmaChannels[channel].lastTransfer;
+		printf("Strip buffer (%zu bytes, DMA channel %i):\n", strip.size(), channel);
+		for (size_t i = 0; i < strip.size(); i++)
+		{
+			if (i % 16 == 0)
+				printf("%06zx:", i);
+			printf(" %02x", strip[i]);
+			if (i % 16 == 15 || i + 1 == strip.size())
+				printf("\n");
+		}
+	}
+}
+
+static uint64_t readNumber(const std::vector<uint8_t>& data, size_t offset, int bytes)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < bytes; i++)
+		value |= (uint64_t)data[offset + i] << (8 * i);
+	return value;
+}
+
+/**
+ * @brief Send the control frame and read the telemetry record of the response like the host tool does
+ *
+ * @param command
+ * @param type expected record type
+ * @param version expected payload version
+ * @param payload [out]
+ * @return false if the response is not a valid record
+ */
+static bool requestTelemetry(uint8_t command, uint8_t type, uint8_t version, std::vector<uint8_t>& payload)
+{
+	const uint8_t request[] = { 'A', 'w', 'a', 0x2a, 0xa2, command };
+	std::vector<uint8_t> record;
+
+	logCapture = &record;
+	feed(request, sizeof(request));
+	logCapture = nullptr;
+
+	if (record.size() < TELEMETRY_HEADER_SIZE + 2 || memcmp(record.data(), "Awt", 3) != 0 || record[3] != type ||
+		record[4] != version || readNumber(record, 5, 2) + TELEMETRY_HEADER_SIZE + 2 != record.size())
+	{
+		printf("Invalid telemetry record (%zu bytes)\n", record.size());
+		return false;
+	}
+
+	uint16_t fletcher1 = 0, fletcher2 = 0;
+	for (size_t i = 3; i < record.size() - 2; i++)
+	{
+		fletcher1 = (fletcher1 + record[i]) % 255;
+		fletcher2 = (fletcher2 + fletcher1) % 255;
+	}
+
+	if (fletcher1 != record[record.size() - 2] || fletcher2 != record[record.size() - 1])
+	{
+		printf("Broken telemetry record checksum\n");
+		return false;
+	}
+
+	payload.assign(record.begin() + TELEMETRY_HEADER_SIZE, record.end() - 2);
+	return true;
+}
+
+/**
+ * @brief Request the binary statistics and verify them against the replay
+ *
+ * @return false if the record is broken
+ */
+static bool printStatisticsRecord()
+{
+	std::vector<uint8_t> payload;
+	uint32_t latencyFrames = statistics.getTotalLatency().getSamples();
+	uint32_t resyncs = statistics.getResyncs();
+
+	if (!requestTelemetry(COMMAND_STATISTICS_BINARY, TELEMETRY_STATISTICS, TELEMETRY_STATISTICS_VERSION, payload))
+		return false;
+
+	if (payload.size() != TELEMETRY_STATISTICS_PAYLOAD || readNumber(payload, 62, 4) != base.ring.capacity() || readNumber(payload, 154, 4) != latencyFrames ||
+		readNumber(payload, 162, 4) != resyncs)
+	{
+		printf("Statistics record: unexpected content (%zu bytes)\n", payload.size());
+		return false;
+	}
+
+	printf("Statistics record: %zu bytes, USB reads: %u, ring size: %u, latency frames: %u, resyncs: %u, discarded bytes/resync: %u\n",
+		payload.size(), (unsigned int)readNumber(payload, 46, 4), (unsigned int)readNumber(payload, 62, 4),
+		(unsigned int)readNumber(payload, 154, 4), (unsigned int)readNumber(payload, 162, 4), (unsigned int)readNumber(payload, 166, 4));
+
+	// the request has started the new period: the next record counts only the USB reads of its own request (6 bytes)
+	if (!requestTelemetry(COMMAND_STATISTICS_BINARY, TELEMETRY_STATISTICS, TELEMETRY_STATISTICS_VERSION, payload))
+		return false;
+
+	if (readNumber(payload, 46, 4) != (6 + options.chunk - 1) / options.chunk || readNumber(payload, 50, 4) != 6 ||
+		readNumber(payload, 54, 4) != std::min((size_t)6, options.chunk))
+	{
+		printf("Statistics record: the USB counters were not reset (reads: %u, bytes: %u, max: %u)\n",
+			(unsigned int)readNumber(payload, 46, 4), (unsigned int)readNumber(payload, 50, 4), (unsigned int)readNumber(payload, 54, 4));
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Request the text statistics: core1 queues only the values and core0 formats the lines when it drains the output
+ *
+ * @return false if the report is incomplete or the welcome message queued after it overtakes it
+ */
+static bool printTextReport()
+{
+	const uint8_t request[] = { 'A', 'w', 'a', 0x2a, 0xa2, COMMAND_STATISTICS };
+	std::vector<uint8_t> output;
+
+	logCapture = &output;
+	feed(request, sizeof(request));
+	logCapture = nullptr;
+
+	std::string text(output.begin(), output.end());
+	size_t lut = text.find("LUT => "), hello = text.find(HELLO_MESSAGE);
+
+	if (text.find("HyperHDR frames: ") != 0 || text.find("Latency total => ") == std::string::npos || lut == std::string::npos ||
+		hello == std::string::npos || hello < lut)
+	{
+		printf("Text report: incomplete or out of order (%zu bytes)\n", text.size());
+		return false;
+	}
+
+	printf("Text report: %zu bytes, %zu lines\n", text.size(), (size_t)std::count(text.begin(), text.begin() + hello, '\n'));
+	return true;
+}
+
+#if defined(HYPERSERIAL_PROFILE)
+	/**
+	 * @brief Request the profile telemetry record and print it
+	 *
+	 * @return false if the record is broken
+	 */
+	static bool printProfile()
+	{
+		static const char* stages[] = { "header", "fletcher", "rgb2rgbw", "setPixel", "frameCopy", "stripWait" };
+		std::vector<uint8_t> payload;
+
+		if (!requestTelemetry(COMMAND_PROFILE, TELEMETRY_PROFILE, TELEMETRY_PROFILE_VERSION, payload))
+			return false;
+
+		size_t count = (payload.size() >= 5) ? payload[4] : 0;
+		if (count != std::size(stages) || payload.size() != TELEMETRY_PROFILE_PAYLOAD)
+		{
+			printf("Profile: unexpected content (%zu bytes)\n", payload.size());
+			return false;
+		}
+
+		// the host SysTick follows the host clock: the cycles are only comparable between the stages
+		printf("Profile (payload: %zu bytes, clock: %u MHz):\n", payload.size(), (unsigned int)(readNumber(payload, 0, 4) / 1000000));
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t calls = readNumber(payload, 5 + i * 12, 4), cycles = readNumber(payload, 9 + i * 12, 8);
+
+			printf("  %-10s calls: %llu, cycles: %llu, cycles/call: %.1f\n", stages[i], (unsigned long long)calls,
+				(unsigned long long)cycles, (calls > 0) ? (double)cycles / calls : 0.0);
+		}
+
+		return true;
+	}
+#endif
+
+static void usage(const char* name)
+{
+	printf("Usage: %s [options] [input]\n"
+		"  input          recorded AWA stream: a file or a serial/pty device (default: synthetic stream)\n"
+		"  -l <leds>      synthetic stream: number of LEDs (default: %i)\n"
+		"  -f <frames>    synthetic stream: number of frames (default: %i)\n"
+		"  -p <1|2|3>     synthetic stream: AWA protocol version (default: %i)\n"
+		"  -s <seed>      synthetic stream: random seed (default: %u)\n"
+		"  -o <file>      save the synthetic stream to the file\n"
+		"  -c <bytes>     bytes delivered by a single USB callback (default: %zu)\n"
+		"  -r <count>     replay the stream <count> times (default: %i)\n"
+		"  -u <ranges>    synthetic stream: after the first frame change only <ranges> random ranges of the pixels\n"
+		"  -x             synthetic stream: send the changed ranges as the delta frames (requires -u)\n"
+		"  -z             synthetic stream: send the full frames compressed (runs and palette)\n"
+		"  -t <fps>       synthetic stream: emulate the host that sends <fps> frames/s (default: no pauses)\n"
+		"  -e <fraction>  synthetic stream: send the high precision frames (16-bit channels) with the low byte <fraction>\n"
+		"  -w <us>        synthetic stream: the host stalls for <us> in the middle of every frame\n"
+		"  -g <layout>    synthetic stream: start with the segments layout control frame, e.g. 300,600:5\n"
+		"                 (starting indexes of the next segments and optional reversed lanes mask)\n"
+		"  -k <gamma>     synthetic stream: upload the color LUT first, gamma and optional white balance, e.g. 2.2:1,0.9,0.8\n"
+		"  -j <pattern>   synthetic stream: damage every n-th frame (default: 10) and report the recovery, e.g. truncate:10\n"
+		"                 (truncate, bitflip, count, half, embedded, all)\n"
+		"  -d             dump the final strip buffer\n"
+		"  -b <name>      run the kernel benchmark instead of the replay: fletcher, lanes, blend, dither, lut, compress, ring, all\n"
+		"                 (compress: uses the recorded input stream if provided)\n",
+		name, options.leds, options.frames, options.version, options.seed, options.chunk, options.repeat);
+}
+
+static bool parseArguments(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (arg[0] != '-')
+		{
+			options.input = arg;
+			continue;
+		}
+		else if (strcmp(arg, "-d") == 0)
+		{
+			options.dump = true;
+			continue;
+		}
+		else if (strcmp(arg, "-x") == 0)
+		{
+			options.delta = true;
+			continue;
+		}
+		else if (strcmp(arg, "-z") == 0)
+		{
+			options.compressed = true;
+			continue;
+		}
+		else if (value == nullptr)
+			return false;
+
+		i++;
+		if (strcmp(arg, "-l") == 0)
+			options.leds = atoi(value);
+		else if (strcmp(arg, "-f") == 0)
+			options.frames = atoi(value);
+		else if (strcmp(arg, "-p") == 0)
+			options.version = atoi(value);
+		else if (strcmp(arg, "-s") == 0)
+			options.seed = strtoul(value, nullptr, 10);
+		else if (strcmp(arg, "-o") == 0)
+			options.output = value;
+		else if (strcmp(arg, "-c") == 0)
+			options.chunk = strtoul(value, nullptr, 10);
+		else if (strcmp(arg, "-r") == 0)
+			options.repeat = atoi(value);
+		else if (strcmp(arg, "-b") == 0)
+			options.benchmark = value;
+		else if (strcmp(arg, "-g") == 0)
+			options.layout = value;
+		else if (strcmp(arg, "-k") == 0)
+			options.lut = value;
+		else if (strcmp(arg, "-u") == 0)
+			options.updates = atoi(value);
+		else if (strcmp(arg, "-t") == 0)
+			options.rate = atoi(value);
+		else if (strcmp(arg, "-w") == 0)
+			options.stall = atoi(value);
+		else if (strcmp(arg, "-e") == 0)
+			options.fraction = atoi(value);
+		else if (strcmp(arg, "-j") == 0)
+		{
+			options.corruption = value;
+			if (!parseCorruption(value))
+				return false;
+		}
+		else
+			return false;
+	}
+
+	options.chunk = std::clamp(options.chunk, (size_t)1, (size_t)(MAX_BUFFER - 1));
+
+	// the delta and compressed frames have no calibration trailer of the protocol version 2
+	if ((options.delta && options.updates <= 0) || ((options.delta || options.compressed) && options.version == 2))
+		return false;
+
+	// the checksums don't cover the header: the delta frame with a wrong LED count (and a valid CRC) is still valid
+	if (options.delta && options.corruption != nullptr && corruptionStats.pattern == Corruption::count)
+		return false;
+
+	// the high precision frames have 16-bit R, G, B channels only
+	if (options.fraction > 255 || (options.fraction >= 0 && (options.version != 1 || options.delta || options.compressed)))
+		return false;
+
+	return options.leds >= 1 && options.leds <= 4096 && options.frames >= 0 &&
+			options.version >= 1 && options.version <= 3 && options.repeat >= 1 && options.updates >= 0 && options.rate >= 0;
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<uint8_t> stream;
+	std::vector<size_t> frameEnds;
+	uint64_t expectedFrames = 0;
+
+	if (!parseArguments(argc, argv))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (options.benchmark != nullptr)
+		return runBenchmark(options.benchmark, options.seed, options.input);
+
+	printf("HyperSerialPico host replay, LED driver: %s\n", _XSTR(LED_DRIVER));
+
+	sem_init(&base.receiverSemaphore, 0, 1);
+
+	if (options.input != nullptr)
+	{
+		int fd = open(options.input, O_RDONLY | O_NOCTTY);
+		if (fd < 0)
+		{
+			fprintf(stderr, "Could not open: %s\n", options.input);
+			return 1;
+		}
+
+		if (isatty(fd))
+		{
+			printf("Input: %s (device)\n", options.input);
+			feedFromDevice(fd);
+			options.repeat = 0;
+		}
+		else if (!readFile(fd, stream))
+		{
+			fprintf(stderr, "Could not read: %s\n", options.input);
+			close(fd);
+			return 1;
+		}
+		close(fd);
+	}
+	else
+	{
+		std::mt19937 rng(options.seed);
+		std::vector<uint8_t> pixels;
+
+		if (options.layout != nullptr && !appendSegmentsLayout(stream, options.layout))
+		{
+			fprintf(stderr, "Invalid segments layout: %s\n", options.layout);
+			return 1;
+		}
+
+		if (options.lut != nullptr && !appendColorLut(stream, options.lut))
+		{
+			fprintf(stderr, "Invalid color LUT: %s\n", options.lut);
+			return 1;
+		}
+
+		for (int i = 0; i < options.frames; i++)
+		{
+			appendRandomFrame(stream, pixels, rng);
+			frameEnds.push_back(stream.size());
+		}
+		expectedFrames = (uint64_t)options.frames * options.repeat;
+
+		if (options.corruption != nullptr)
+			corruptStream(stream, frameEnds, rng);
+
+		if (options.output != nullptr)
+		{
+			FILE* file = fopen(options.output, "wb");
+			if (file == nullptr || fwrite(stream.data(), 1, stream.size(), file) != stream.size())
+			{
+				fprintf(stderr, "Could not write: %s\n", options.output);
+				return 1;
+			}
+			fclose(file);
+		}
+
+		printf("Input: synthetic, leds: %i, frames: %i, protocol version: %i%s%s\n", options.leds, options.frames, options.version,
+			(options.delta) ? ", delta frames" : ((options.compressed) ? ", compressed frames" :
+			((options.fraction >= 0) ? ", high precision frames" : "")), (options.corruption != nullptr) ? ", damaged frames" : "");
+	}
+
+	for (int i = 0; i < options.repeat; i++)
+	{
+		if ((options.rate > 0 || options.stall > 0 || options.corruption != nullptr) && !frameEnds.empty())
+		{
+			// frame by frame: at the host rate, with the stalls or to see which frames were accepted,
+			// the beginning (e.g. the segments layout) comes together with the first frame
+			std::vector<bool> accepted;
+			size_t position = 0;
+
+			for (size_t end : frameEnds)
+			{
+				// every valid frame adds the receive latency sample
+				uint32_t validFrames = statistics.getReceiveLatency().getSamples();
+
+				if (options.rate > 0)
+					idle(time_us_64() + 1000000 / options.rate);
+
+				if (options.stall > 0)
+				{
+					size_t middle = position + (end - position) / 2;
+
+					feed(stream.data() + position, middle - position);
+					idle(time_us_64() + options.stall);
+					position = middle;
+				}
+
+				feed(stream.data() + position, end - position);
+				position = end;
+				accepted.push_back(statistics.getReceiveLatency().getSamples() != validFrames);
+
+				#if defined(STREAMING_RENDER)
+					if (frameState.getState() == AwaProtocol::HEADER_A && base.isStreaming())
+						corruptionStats.strayStreams++;
+				#endif
+			}
+
+			if (options.corruption != nullptr)
+				addCorruptionResults(frameEnds, accepted);
+		}
+		else
+			feed(stream.data(), stream.size());
+	}
+
+	#if defined(INTERPOLATION_RENDER)
+		// let the last transition finish
+		idle(time_us_64() + INTERPOLATION_MAX_TIME + INTERPOLATION_PERIOD);
+	#elif defined(RENDER_SCHEDULER)
+		// let the scheduler submit the last frame
+		idle(time_us_64() + 100000);
+	#else
+		// the last frame could wait for the latch alarm
+		idle(time_us_64() + 1000);
+	#endif
+
+	double seconds = std::max(replayStats.parserTime, (uint64_t)1) / 1e9;
+
+	printf("Bytes: %llu, chunk: %zu, parser time: %.3f ms\n", (unsigned long long)replayStats.bytes, options.chunk, seconds * 1000);
+	uint64_t renderedFrames = shim::renderedFrames();
+
+	printf("Rendered frames: %llu, frames/s: %.1f, bytes/s: %.0f\n", (unsigned long long)renderedFrames,
+		renderedFrames / seconds, replayStats.bytes / seconds);
+	printf("Emulated waits (busy_wait_us/sleep_ms): %.3f ms\n", shim::skippedTime / 1000.0);
+
+	// the latch time that the parser didn't wait for: the DMA was started by the alarm
+	uint32_t latchDeferred;
+	uint64_t latchReclaimed;
+	DmaClient::getLatchStatistics(latchDeferred, latchReclaimed);
+	printf("Latch alarm starts: %u, reclaimed time: %.3f ms\n", (unsigned int)latchDeferred, latchReclaimed / 1000.0);
+	printf("Doorbells: %u, max wake-up latency: %u us\n", (unsigned int)statistics.getWakeUps(),
+		(unsigned int)statistics.getWakeUpLatencyMax());
+	printf("USB reads: %u, bytes/read: %u, max: %u\n", (unsigned int)statistics.getUsbReads(),
+		(unsigned int)statistics.getUsbBytesPerRead(), (unsigned int)statistics.getUsbMaxBytesPerRead());
+	printf("Ring size: %u, dropped bytes: %u\n", (unsigned int)base.ring.capacity(), (unsigned int)base.ring.getDropped());
+
+	// emulated time: the DMA is instant, the header to validation time follows the chunk size
+	printf("Frame latency p50/p99/max [us]:");
+	for (const auto& [name, histogram] : { std::make_pair("receive", &statistics.getReceiveLatency()),
+			std::make_pair("queue", &statistics.getQueueLatency()), std::make_pair("total", &statistics.getTotalLatency()) })
+		printf(" %s %u/%u/%u,", name, (unsigned int)histogram->getPercentile(50), (unsigned int)histogram->getPercentile(99),
+			(unsigned int)histogram->getMax());
+	printf(" frames: %u\n", (unsigned int)statistics.getTotalLatency().getSamples());
+
+	#if defined(STREAMING_RENDER)
+		// the host DMA is instant: it always waits for the parser
+		printf("Streaming underruns: %u, repaired frames: %u, latched frames: %u, longest gap: %llu us\n",
+			(unsigned int)statistics.getStreamUnderruns(), (unsigned int)statistics.getStreamRepairs(),
+			(unsigned int)statistics.getStreamLatched(), (unsigned long long)shim::longestChainGap);
+
+		// the gap longer than the reset time shows the partial frame, the rest would start from the first LED
+		if (base.getLedStrip1() != nullptr && shim::longestChainGap >= base.getLedStrip1()->getResetTime())
+		{
+			printf("Streaming: the LEDs have latched the partially sent frame\n");
+			return 1;
+		}
+
+		// the partially sent part of the latched frame is followed by the whole frame
+		expectedFrames += statistics.getStreamLatched();
+	#endif
+
+	#if defined(INTERPOLATION_RENDER)
+		// the output rate doesn't follow the input frames
+		printf("Interpolated output frames: %llu (input frames: %llu, output rate: %i)\n", (unsigned long long)renderedFrames,
+			(unsigned long long)expectedFrames, INTERPOLATION_RENDER);
+		expectedFrames = renderedFrames;
+	#endif
+
+	#if defined(RENDER_SCHEDULER)
+		// the frames that came faster than the strip (and the frame pacing) could send them
+		printf("Dropped late frames: %u\n", (unsigned int)statistics.getDroppedLateFrames());
+		expectedFrames -= std::min(expectedFrames, (uint64_t)statistics.getDroppedLateFrames());
+	#endif
+
+	#if defined(DITHERING_RENDER)
+		// the frames with the fractional parts are sent again whenever the strip is idle
+		printf("Dithered repeated frames: %u\n", (unsigned int)statistics.getDitheredFrames());
+		expectedFrames += statistics.getDitheredFrames();
+	#endif
+
+	if (options.corruption != nullptr)
+	{
+		// the last damaged frame could still wait for its announced length: the parser drops it after the timeout
+		idle(time_us_64() + 5100000);
+
+		if (!printCorruptionResults())
+			return 1;
+
+		// only the accepted frames are rendered, the streamed ones can be repaired with the last good frame
+		expectedFrames = renderedFrames;
+	}
+
+	if (!printStatisticsRecord() || !printTextReport())
+		return 1;
+
+	#if defined(HYPERSERIAL_PROFILE)
+		if (!printProfile())
+			return 1;
+	#endif
+
+	if (options.dump)
+		dumpStripBuffer();
+
+	if (options.input == nullptr && renderedFrames != expectedFrames)
+	{
+		printf("Lost frames: %llu of %llu\n", (unsigned long long)(expectedFrames - std::min(expectedFrames, renderedFrames)),
+			(unsigned long long)expectedFrames);
+		return 1;
+	}
+
+	return 0;
+}
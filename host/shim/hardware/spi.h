@@ -0,0 +1,4 @@
+#pragma once
+
+// host replacement for <hardware/spi.h>, see pico_shim.h
+#include "../pico_shim.h"
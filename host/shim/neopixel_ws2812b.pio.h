@@ -0,0 +1,17 @@
+#pragma once
+
+// host replacement for the header generated by pioasm from pio/neopixel_ws2812b.pio, see pico_shim.h
+#include "pico_shim.h"
+
+static const pio_program_t neopixel_ws2812b_program = { nullptr, 4, -1 };
+static const pio_program_t neopixel_ws2812b_parallel_program = { nullptr, 4, -1 };
+
+static inline pio_sm_config neopixel_ws2812b_program_get_default_config(uint offset)
+{
+	return pio_get_default_sm_config();
+}
+
+static inline pio_sm_config neopixel_ws2812b_parallel_program_get_default_config(uint offset)
+{
+	return pio_get_default_sm_config();
+}
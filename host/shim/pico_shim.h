@@ -0,0 +1,822 @@
+/* pico_shim.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+/*
+	Minimal host (Linux) replacement for the pico-sdk and FreeRTOS calls used by
+	the HyperSerialPico led drivers and the AWA parser. Only the behaviour that
+	the firmware depends on is emulated:
+	- time_us_64/xTaskGetTickCount follow the host monotonic clock
+	- busy_wait_us/sleep_ms do not sleep, they advance the emulated clock instead
+	  so the parser throughput is not hidden behind latch/reset waits
+	- hardware alarms fire when the emulated clock passes their target: in busy_wait_us/sleep_ms
+	  or when the replay driver calls shim::runAlarms() (core1 waiting for the data),
+	  but not while the interrupts are disabled
+	- the inter-core FIFO is a queue of 8 words: core1 pops what core0 pushed before it was called
+	- DMA transfers complete instantly: the transferred data is captured per channel
+	  and the DMA_IRQ_0 handler is called like on the real hardware, memory to memory
+	  transfers (write increment) are executed, the chunks of the streamed transfer
+	  (continuing from the end of the previous one) are captured as one transfer,
+	  the longest idle time between them is recorded (the LEDs latch after their reset time)
+	- the SysTick counts down the host time at the nominal 125MHz (with the skipped waits)
+	- the PIO state machines and the size of the instruction memory are allocated, the rest of PIO,
+	  SPI, GPIO and clocks is accepted and ignored
+*/
+
+#ifndef PICO_SHIM_H
+#define PICO_SHIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+typedef unsigned int uint;
+
+[[noreturn]] inline void panic(const char* message)
+{
+	fprintf(stderr, "Panic: %s\n", message);
+	abort();
+}
+
+///////////////////////////////////////////////////////////////////////////
+// time
+///////////////////////////////////////////////////////////////////////////
+
+namespace shim
+{
+	inline const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+	// time that was waited by the firmware, but skipped by the shim
+	inline uint64_t skippedTime = 0;
+}
+
+inline uint64_t time_us_64()
+{
+	auto elapsed = std::chrono::steady_clock::now() - shim::bootTime;
+	return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + shim::skippedTime;
+}
+
+inline uint32_t time_us_32()
+{
+	return (uint32_t)time_us_64();
+}
+
+///////////////////////////////////////////////////////////////////////////
+// SysTick
+///////////////////////////////////////////////////////////////////////////
+
+// the current value: 24-bit down counter at 125MHz, the writes are ignored
+struct systick_cvr_t
+{
+	operator uint32_t() const
+	{
+		auto elapsed = std::chrono::steady_clock::now() - shim::bootTime;
+		uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() + shim::skippedTime * 1000;
+		return 0xffffff - (uint32_t)((ns / 8) & 0xffffff);
+	}
+
+	systick_cvr_t& operator=(uint32_t) { return *this; }
+};
+
+struct systick_hw_t
+{
+	uint32_t csr;
+	uint32_t rvr;
+	systick_cvr_t cvr;
+	uint32_t calib;
+};
+
+namespace shim
+{
+	inline systick_hw_t systickHw = {};
+}
+
+#define systick_hw (&shim::systickHw)
+
+///////////////////////////////////////////////////////////////////////////
+// hardware alarms
+///////////////////////////////////////////////////////////////////////////
+
+#define NUM_TIMERS 4
+
+typedef uint64_t absolute_time_t;
+typedef void (*hardware_alarm_callback_t)(uint alarm_num);
+
+inline absolute_time_t from_us_since_boot(uint64_t us)
+{
+	return us;
+}
+
+namespace shim
+{
+	struct Alarm
+	{
+		bool claimed = false;
+		bool armed = false;
+		uint64_t target = 0;
+		hardware_alarm_callback_t callback = nullptr;
+	};
+
+	inline Alarm alarms[NUM_TIMERS];
+	// save_and_disable_interrupts nesting: the alarms don't fire inside
+	inline int interruptsDisabled = 0;
+
+	/**
+	 * @brief Fire the armed alarms whose target has passed
+	 *
+	 */
+	inline void runAlarms()
+	{
+		for (uint i = 0; i < NUM_TIMERS && interruptsDisabled == 0; i++)
+			if (alarms[i].armed && alarms[i].target <= time_us_64())
+			{
+				alarms[i].armed = false;
+				if (alarms[i].callback != nullptr)
+					alarms[i].callback(i);
+			}
+	}
+}
+
+inline int hardware_alarm_claim_unused(bool required)
+{
+	for (int i = 0; i < NUM_TIMERS; i++)
+		if (!shim::alarms[i].claimed)
+		{
+			shim::alarms[i] = shim::Alarm();
+			shim::alarms[i].claimed = true;
+			return i;
+		}
+
+	if (required)
+	{
+		fprintf(stderr, "No hardware alarm available\n");
+		abort();
+	}
+	return -1;
+}
+
+inline void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback)
+{
+	shim::alarms[alarm_num].callback = callback;
+}
+
+// like the pico-sdk: true if the target has already passed (the alarm is not armed then)
+inline bool hardware_alarm_set_target(uint alarm_num, absolute_time_t target)
+{
+	shim::alarms[alarm_num].target = target;
+	shim::alarms[alarm_num].armed = target > time_us_64();
+	return !shim::alarms[alarm_num].armed;
+}
+
+inline void hardware_alarm_cancel(uint alarm_num)
+{
+	shim::alarms[alarm_num].armed = false;
+}
+
+inline void busy_wait_us(uint64_t delay_us)
+{
+	shim::skippedTime += delay_us;
+	shim::runAlarms();
+}
+
+inline void sleep_ms(uint32_t ms)
+{
+	shim::skippedTime += ms * 1000ull;
+	shim::runAlarms();
+}
+
+///////////////////////////////////////////////////////////////////////////
+// FreeRTOS
+///////////////////////////////////////////////////////////////////////////
+
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef unsigned long UBaseType_t;
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+inline TickType_t xTaskGetTickCount()
+{
+	return (TickType_t)(time_us_64() / 1000);
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t)
+{
+	return 0;
+}
+
+inline size_t xPortGetFreeHeapSize()
+{
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// semaphores (single threaded host: no blocking)
+///////////////////////////////////////////////////////////////////////////
+
+struct semaphore_t
+{
+	int16_t permits;
+	int16_t max_permits;
+};
+
+inline void sem_init(semaphore_t *sem, int16_t initial_permits, int16_t max_permits)
+{
+	sem->permits = initial_permits;
+	sem->max_permits = max_permits;
+}
+
+inline bool sem_release(semaphore_t *sem)
+{
+	if (sem->permits < sem->max_permits)
+	{
+		sem->permits++;
+		return true;
+	}
+	return false;
+}
+
+inline bool sem_acquire_timeout_us(semaphore_t *sem, uint32_t)
+{
+	if (sem->permits > 0)
+	{
+		sem->permits--;
+		return true;
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// inter-core FIFO (single threaded host: core0 always pushes before core1 pops)
+///////////////////////////////////////////////////////////////////////////
+
+namespace shim
+{
+	inline std::deque<uint32_t> fifo;
+	constexpr size_t fifoDepth = 8;
+}
+
+inline bool multicore_fifo_wready()
+{
+	return shim::fifo.size() < shim::fifoDepth;
+}
+
+inline bool multicore_fifo_rvalid()
+{
+	return !shim::fifo.empty();
+}
+
+inline void multicore_fifo_push_blocking(uint32_t data)
+{
+	if (!multicore_fifo_wready())
+	{
+		fprintf(stderr, "Inter-core FIFO is full: core0 would wait forever\n");
+		abort();
+	}
+	shim::fifo.push_back(data);
+}
+
+inline uint32_t multicore_fifo_pop_blocking()
+{
+	if (!multicore_fifo_rvalid())
+	{
+		fprintf(stderr, "Inter-core FIFO is empty: core1 would wait forever\n");
+		abort();
+	}
+
+	uint32_t data = shim::fifo.front();
+	shim::fifo.pop_front();
+	return data;
+}
+
+inline bool multicore_fifo_pop_timeout_us(uint64_t timeout_us, uint32_t *out)
+{
+	if (!multicore_fifo_rvalid())
+	{
+		busy_wait_us(timeout_us);
+		return false;
+	}
+
+	*out = multicore_fifo_pop_blocking();
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// IRQ
+///////////////////////////////////////////////////////////////////////////
+
+// single threaded host: the IRQ handlers are called synchronously
+inline uint32_t save_and_disable_interrupts()
+{
+	shim::interruptsDisabled++;
+	return 0;
+}
+
+inline void restore_interrupts(uint32_t)
+{
+	// the alarm that was due meanwhile fires now
+	if (--shim::interruptsDisabled == 0)
+		shim::runAlarms();
+}
+
+#define DMA_IRQ_0 11
+
+typedef void (*irq_handler_t)(void);
+
+namespace shim
+{
+	inline irq_handler_t dmaIrq0Handler = nullptr;
+	inline bool dmaIrq0Enabled = false;
+}
+
+inline void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+	if (num == DMA_IRQ_0)
+		shim::dmaIrq0Handler = handler;
+}
+
+inline void irq_set_enabled(uint num, bool enabled)
+{
+	if (num == DMA_IRQ_0)
+		shim::dmaIrq0Enabled = enabled;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// DMA
+///////////////////////////////////////////////////////////////////////////
+
+#define NUM_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size
+{
+	DMA_SIZE_8 = 0,
+	DMA_SIZE_16 = 1,
+	DMA_SIZE_32 = 2
+};
+
+struct dma_channel_config
+{
+	dma_channel_transfer_size size;
+	bool readIncrement;
+	bool writeIncrement;
+	uint dreq;
+};
+
+// the interrupt status register: writing 1 clears the bit
+struct dma_ints_t
+{
+	uint32_t pending = 0;
+
+	operator uint32_t() const { return pending; }
+	dma_ints_t& operator=(uint32_t clear) { pending &= ~clear; return *this; }
+	dma_ints_t& operator|=(uint32_t raise) { pending |= raise; return *this; }
+};
+
+struct dma_hw_t
+{
+	dma_ints_t ints0;
+};
+
+namespace shim
+{
+	struct DmaChannel
+	{
+		bool claimed = false;
+		bool irq0Enabled = false;
+		dma_channel_config config = {};
+		volatile void* writeAddr = nullptr;
+		const volatile void* readAddr = nullptr;
+		uint transferCount = 0;
+		// end of the last transfer: the transfer that continues from here is a chunk of the same stream
+		const uint8_t* chainEnd = nullptr;
+		uint64_t chainTime = 0;
+
+		// host statistics and the data captured from the last transfer (all chunks of the stream)
+		uint64_t transfers = 0;
+		uint64_t transferredBytes = 0;
+		std::vector<uint8_t> lastTransfer;
+	};
+
+	inline DmaChannel dmaChannels[NUM_DMA_CHANNELS];
+	inline dma_hw_t dmaHw = {};
+	inline int lastDmaChannel = -1;
+	inline uint64_t dmaTransfers = 0;
+
+	// the longest idle time between the chunks of a streamed transfer [us]
+	inline uint64_t longestChainGap = 0;
+
+	// frames sent to the outputs: every channel of the frame (one per independent lane) transfers exactly once
+	inline uint64_t dmaFrames = 0;
+	inline uint32_t frameChannels = 0;
+
+	inline uint64_t renderedFrames()
+	{
+		return dmaFrames + ((frameChannels != 0) ? 1 : 0);
+	}
+
+	inline void dmaTransfer(uint channel)
+	{
+		DmaChannel& ch = dmaChannels[channel];
+		size_t unit = 1u << ch.config.size;
+		size_t total = unit * ch.transferCount;
+		const uint8_t* source = reinterpret_cast<const uint8_t*>(const_cast<const void*>(ch.readAddr));
+
+		if (ch.config.writeIncrement)
+		{
+			uint8_t* target = reinterpret_cast<uint8_t*>(const_cast<void*>(ch.writeAddr));
+			for (size_t i = 0; i < total && source != nullptr && target != nullptr; i += unit)
+				memcpy(target + i, source + ((ch.config.readIncrement) ? i : 0), unit);
+
+			ch.transfers++;
+			ch.transferredBytes += total;
+			return;
+		}
+
+		bool chained = (source != nullptr && source == ch.chainEnd && ch.config.readIncrement);
+		size_t offset = (chained) ? ch.lastTransfer.size() : 0;
+
+		ch.lastTransfer.resize(offset + total);
+		for (size_t i = 0; i < total && source != nullptr; i += unit)
+			memcpy(&ch.lastTransfer[offset + i], source + ((ch.config.readIncrement) ? i : 0), unit);
+		ch.chainEnd = (source != nullptr) ? source + total : nullptr;
+
+		if (chained)
+			longestChainGap = std::max(longestChainGap, time_us_64() - ch.chainTime);
+		ch.chainTime = time_us_64();
+
+		ch.transfers++;
+		ch.transferredBytes += total;
+		lastDmaChannel = channel;
+
+		if (!chained)
+		{
+			dmaTransfers++;
+
+			if (frameChannels & (1u << channel))
+			{
+				dmaFrames++;
+				frameChannels = 0;
+			}
+			frameChannels |= (1u << channel);
+		}
+
+		if (ch.irq0Enabled && dmaIrq0Enabled && dmaIrq0Handler != nullptr)
+		{
+			dmaHw.ints0 |= (1u << channel);
+			dmaIrq0Handler();
+		}
+	}
+}
+
+#define dma_hw (&shim::dmaHw)
+
+inline int dma_claim_unused_channel(bool required)
+{
+	for (int i = 0; i < NUM_DMA_CHANNELS; i++)
+		if (!shim::dmaChannels[i].claimed)
+		{
+			shim::dmaChannels[i] = shim::DmaChannel();
+			shim::dmaChannels[i].claimed = true;
+			return i;
+		}
+
+	if (required)
+	{
+		fprintf(stderr, "No DMA channel available\n");
+		abort();
+	}
+	return -1;
+}
+
+inline void dma_channel_unclaim(uint channel)
+{
+	shim::dmaChannels[channel].claimed = false;
+	shim::frameChannels &= ~(1u << channel);
+}
+
+inline void dma_channel_abort(uint)
+{
+}
+
+inline void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+	shim::dmaChannels[channel].irq0Enabled = enabled;
+}
+
+inline dma_channel_config dma_channel_get_default_config(uint)
+{
+	dma_channel_config config = { DMA_SIZE_32, true, false, 0x3f };
+	return config;
+}
+
+inline void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+	c->dreq = dreq;
+}
+
+inline void channel_config_set_transfer_data_size(dma_channel_config *c, dma_channel_transfer_size size)
+{
+	c->size = size;
+}
+
+inline void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+	c->readIncrement = incr;
+}
+
+inline void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+	c->writeIncrement = incr;
+}
+
+inline void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+									const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+	shim::DmaChannel& ch = shim::dmaChannels[channel];
+	ch.config = *config;
+	ch.writeAddr = write_addr;
+	ch.readAddr = read_addr;
+	ch.transferCount = transfer_count;
+
+	if (trigger)
+		shim::dmaTransfer(channel);
+}
+
+inline void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger)
+{
+	shim::dmaChannels[channel].readAddr = read_addr;
+
+	if (trigger)
+		shim::dmaTransfer(channel);
+}
+
+inline void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger)
+{
+	shim::dmaChannels[channel].transferCount = trans_count;
+
+	if (trigger)
+		shim::dmaTransfer(channel);
+}
+
+inline void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger)
+{
+	shim::dmaChannels[channel].writeAddr = write_addr;
+
+	if (trigger)
+		shim::dmaTransfer(channel);
+}
+
+inline bool dma_channel_is_busy(uint)
+{
+	return false;
+}
+
+inline void dma_channel_wait_for_finish_blocking(uint)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////
+// PIO
+///////////////////////////////////////////////////////////////////////////
+
+struct pio_hw_t
+{
+	volatile uint32_t txf[4];
+};
+
+typedef pio_hw_t* PIO;
+
+struct pio_program_t
+{
+	const uint16_t *instructions;
+	uint8_t length;
+	int8_t origin;
+};
+
+struct pio_sm_config
+{
+	uint32_t clkdiv;
+	uint32_t execctrl;
+	uint32_t shiftctrl;
+	uint32_t pinctrl;
+};
+
+enum pio_fifo_join
+{
+	PIO_FIFO_JOIN_NONE = 0,
+	PIO_FIFO_JOIN_TX = 1,
+	PIO_FIFO_JOIN_RX = 2
+};
+
+#define NUM_PIO_STATE_MACHINES 4
+#define PIO_INSTRUCTION_COUNT 32
+
+namespace shim
+{
+	inline pio_hw_t pio0Hw = {};
+	inline pio_hw_t pio1Hw = {};
+	inline uint32_t pio0ClaimedSm = 0;
+	inline uint32_t pio1ClaimedSm = 0;
+	// used instruction memory (the programs are not relocated, only their sizes are counted)
+	inline uint32_t pioInstructions[2] = {};
+}
+
+#define pio0 (&shim::pio0Hw)
+#define pio1 (&shim::pio1Hw)
+
+inline int pio_claim_unused_sm(PIO pio, bool required)
+{
+	uint32_t& claimed = (pio == pio0) ? shim::pio0ClaimedSm : shim::pio1ClaimedSm;
+
+	for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++)
+		if (!(claimed & (1u << i)))
+		{
+			claimed |= (1u << i);
+			return i;
+		}
+
+	if (required)
+	{
+		fprintf(stderr, "No PIO state machine available\n");
+		abort();
+	}
+	return -1;
+}
+
+inline void pio_sm_unclaim(PIO pio, uint sm)
+{
+	uint32_t& claimed = (pio == pio0) ? shim::pio0ClaimedSm : shim::pio1ClaimedSm;
+	claimed &= ~(1u << sm);
+}
+
+inline uint pio_get_index(PIO pio)
+{
+	return (pio == pio0) ? 0 : 1;
+}
+
+inline bool pio_can_add_program(PIO pio, const pio_program_t *program)
+{
+	return shim::pioInstructions[pio_get_index(pio)] + program->length <= PIO_INSTRUCTION_COUNT;
+}
+
+inline void pio_remove_program(PIO pio, const pio_program_t *program, uint)
+{
+	shim::pioInstructions[pio_get_index(pio)] -= program->length;
+}
+
+inline pio_sm_config pio_get_default_sm_config()
+{
+	pio_sm_config config = {};
+	return config;
+}
+
+inline uint pio_add_program(PIO pio, const pio_program_t *program)
+{
+	if (!pio_can_add_program(pio, program))
+		panic("No program space");
+
+	uint offset = shim::pioInstructions[pio_get_index(pio)];
+	shim::pioInstructions[pio_get_index(pio)] += program->length;
+	return offset;
+}
+
+inline void pio_gpio_init(PIO, uint)
+{
+}
+
+inline void sm_config_set_out_pins(pio_sm_config *, uint, uint)
+{
+}
+
+inline void sm_config_set_set_pins(pio_sm_config *, uint, uint)
+{
+}
+
+inline void sm_config_set_sideset_pins(pio_sm_config *, uint)
+{
+}
+
+inline void sm_config_set_out_shift(pio_sm_config *, bool, bool, uint)
+{
+}
+
+inline void sm_config_set_fifo_join(pio_sm_config *, pio_fifo_join)
+{
+}
+
+inline void sm_config_set_clkdiv(pio_sm_config *c, float div)
+{
+	c->clkdiv = (uint32_t)(div * 256);
+}
+
+inline int pio_sm_set_consecutive_pindirs(PIO, uint, uint, uint, bool)
+{
+	return 0;
+}
+
+inline int pio_sm_init(PIO, uint, uint, const pio_sm_config *)
+{
+	return 0;
+}
+
+inline void pio_sm_set_enabled(PIO, uint, bool)
+{
+}
+
+inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+	return ((pio == pio0) ? 0 : 8) + ((is_tx) ? 0 : 4) + sm;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// SPI, GPIO, clocks and binary info
+///////////////////////////////////////////////////////////////////////////
+
+struct spi_hw_t
+{
+	volatile uint32_t dr;
+};
+
+struct spi_inst_t
+{
+	spi_hw_t hw;
+};
+
+namespace shim
+{
+	inline spi_inst_t spi0Inst = {};
+	inline spi_inst_t spi1Inst = {};
+}
+
+#define spi0 (&shim::spi0Inst)
+#define spi1 (&shim::spi1Inst)
+
+inline uint spi_init(spi_inst_t *, uint baudrate)
+{
+	return baudrate;
+}
+
+inline spi_hw_t *spi_get_hw(spi_inst_t *spi)
+{
+	return &spi->hw;
+}
+
+inline uint spi_get_dreq(spi_inst_t *spi, bool is_tx)
+{
+	return ((spi == spi0) ? 16 : 18) + ((is_tx) ? 0 : 1);
+}
+
+enum gpio_function
+{
+	GPIO_FUNC_SPI = 1,
+	GPIO_FUNC_PIO0 = 6,
+	GPIO_FUNC_PIO1 = 7
+};
+
+inline void gpio_set_function(uint, gpio_function)
+{
+}
+
+enum clock_index
+{
+	clk_sys = 5
+};
+
+inline uint32_t clock_get_hz(clock_index)
+{
+	return 125000000;
+}
+
+#define PICO_DEFAULT_SPI_RX_PIN 16
+#define PICO_DEFAULT_SPI_CSN_PIN 17
+#define bi_decl(_decl)
+#define bi_4pins_with_func(p0, p1, p2, p3, func)
+
+#endif
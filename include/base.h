@@ -28,30 +28,348 @@
 #ifndef BASE_H
 #define BASE_H
 
+#if defined(SEGMENT_INDEXES)
+	#ifndef SEGMENTS_REVERSED
+		#define SEGMENTS_REVERSED 0
+	#endif
+
+	#define MAX_SEGMENTS 8
+
+	// starting indexes of the 2nd, 3rd... segment and reversing flags for every segment
+	static constexpr int segmentIndexes[] = { SEGMENT_INDEXES };
+	static constexpr bool segmentsReversed[MAX_SEGMENTS] = { SEGMENTS_REVERSED };
+	static constexpr int segmentsConfigured = sizeof(segmentIndexes) / sizeof(segmentIndexes[0]) + 1;
+
+	static_assert(segmentsConfigured <= MAX_SEGMENTS, "Up to 8 segments are supported");
+#endif
+
+#if defined(INTERPOLATION_RENDER)
+	// output period of the interpolated frames and the longest transition between two frames (us)
+	#define INTERPOLATION_PERIOD (1000000 / INTERPOLATION_RENDER)
+	#define INTERPOLATION_MAX_TIME 100000
+#endif
+
+#if defined(FRAME_PACING)
+	// the output frames are evenly spaced by at least this period (us)
+	#define FRAME_PACING_PERIOD (1000000 / FRAME_PACING)
+#endif
+
+#if defined(DITHERING_RENDER)
+	// wake-up period of the render loop: the dithered frame is sent again as soon as the strip is idle (us)
+	#define RENDER_TICK_PERIOD 1000
+#elif defined(INTERPOLATION_RENDER)
+	#define RENDER_TICK_PERIOD INTERPOLATION_PERIOD
+#endif
+
+/**
+ * @brief Blend two colors in the fixed point, every byte (channel) separately: (from * (256 - weight) + to * weight) / 256
+ *
+ * @param from
+ * @param to
+ * @param weight 0-256
+ * @return ColorDefinition
+ */
+static inline ColorDefinition blendColor(const ColorDefinition& from, const ColorDefinition& to, uint32_t weight)
+{
+	ColorDefinition result;
+
+	if constexpr (sizeof(ColorDefinition) == 4)
+	{
+		// two channels in every 16-bit lane of the word
+		uint32_t a, b, rest = 256 - weight;
+
+		memcpy(&a, &from, 4);
+		memcpy(&b, &to, 4);
+
+		uint32_t blend = ((((a & 0x00ff00ff) * rest + (b & 0x00ff00ff) * weight) >> 8) & 0x00ff00ff) |
+						((((a >> 8) & 0x00ff00ff) * rest + ((b >> 8) & 0x00ff00ff) * weight) & 0xff00ff00);
+
+		memcpy(&result, &blend, 4);
+	}
+	else
+	{
+		const uint8_t* a = reinterpret_cast<const uint8_t*>(&from);
+		const uint8_t* b = reinterpret_cast<const uint8_t*>(&to);
+		uint8_t* target = reinterpret_cast<uint8_t*>(&result);
+
+		for (size_t i = 0; i < sizeof(ColorDefinition); i++)
+			target[i] = (a[i] * (256 - weight) + b[i] * weight) >> 8;
+	}
+
+	return result;
+}
+
+#if defined(DITHERING_RENDER)
+	/**
+	 * @brief Color with the 8.8 fixed point channels: the high byte is the output value, the low byte is dithered in time
+	 *
+	 */
+	struct ColorHighPrecision
+	{
+		uint16_t R;
+		uint16_t G;
+		uint16_t B;
+		#if defined(NEOPIXEL_RGBW)
+			uint16_t W;
+		#endif
+	};
+
+	/**
+	 * @brief Accumulated fractional parts of the channels that weren't sent yet
+	 *
+	 */
+	struct ColorDitheringError
+	{
+		uint8_t R;
+		uint8_t G;
+		uint8_t B;
+		uint8_t W;
+	};
+
+	/**
+	 * @brief Temporal dithering of one channel: the fractional part is carried to the next output frame
+	 *
+	 * @param value 8.8 fixed point
+	 * @param error
+	 * @return uint8_t
+	 */
+	static inline uint8_t ditherChannel(uint16_t value, uint8_t& error)
+	{
+		uint32_t sum = (uint32_t)value + error;
+
+		error = (uint8_t)sum;
+		return (sum > 0xffff) ? 0xff : (uint8_t)(sum >> 8);
+	}
+
+	/**
+	 * @brief Temporal dithering of the color (already converted to RGBW)
+	 *
+	 * @param color
+	 * @param error
+	 * @return ColorDefinition
+	 */
+	static inline ColorDefinition ditherColor(const ColorHighPrecision& color, ColorDitheringError& error)
+	{
+		ColorDefinition result;
+
+		result.R = ditherChannel(color.R, error.R);
+		result.G = ditherChannel(color.G, error.G);
+		result.B = ditherChannel(color.B, error.B);
+		#if defined(NEOPIXEL_RGBW)
+			result.W = ditherChannel(color.W, error.W);
+		#endif
+
+		return result;
+	}
+#endif
+
 class Base
 {
 	// LED strip number
 	int ledsNumber = 0;
-	// NeoPixelBusLibrary primary object
+	// NeoPixelBusLibrary primary object (in the multi-segment mode: the first segment that renders all lanes)
 	LED_DRIVER* ledStrip1 = nullptr;
-	// NeoPixelBusLibrary second object
-	LED_DRIVER2* ledStrip2 = nullptr;
+	#if defined(SEGMENT_INDEXES)
+		// segments layout: LED driver, index of the first pixel in the frame, length and reversing
+		struct
+		{
+			LED_DRIVER* strip;
+			int start;
+			int length;
+			bool reversed;
+		} segments[MAX_SEGMENTS];
+		int segmentsNumber = 0;
+		// segment of the last pixel: pixels come in order so it changes only at the segment boundary
+		int currentSegment = 0;
+
+		// requested layout: compile-time defaults, can be changed by the host using the control frame
+		struct
+		{
+			int segments = segmentsConfigured;
+			int indexes[MAX_SEGMENTS - 1];
+			bool reversed[MAX_SEGMENTS];
+		} layout;
+	#endif
 	// frame is set and ready to render
-	bool readyToRender = false;
+	volatile bool readyToRender = false;
+	// the composing buffer still holds the last good frame (it wasn't rendered yet), so it's the base for the delta frame
+	bool composedFrameIsLast = false;
+	#if defined(STREAMING_RENDER)
+		// the frame is being sent while it's still arriving
+		bool streaming = false;
+		// the late frame is the last good frame that replaces the broken stream
+		bool repairFrame = false;
+		// the LEDs have latched the partially streamed frame: the rest is sent as the whole frame once it's valid
+		bool streamLatched = false;
+	#endif
+	#if defined(RENDER_SCHEDULER)
+		// the waiting frame is submitted from the DMA IRQ or from this alarm at the end of the latch time
+		int renderAlarm = -1;
+		// the earliest start of the next frame because of the frame pacing
+		uint64_t nextFrameTime = 0;
+		inline static Base* renderScheduler = nullptr;
+	#endif
+	#if defined(INTERPOLATION_RENDER)
+		// the received frame, the target frame and the frame that the transition starts from (in the frame order)
+		struct
+		{
+			ColorDefinition* incoming = nullptr;
+			ColorDefinition* current = nullptr;
+			ColorDefinition* previous = nullptr;
+			// arrival of the target frame and the length of the transition: the measured interval of the frames
+			uint64_t arrival = 0;
+			uint32_t duration = INTERPOLATION_MAX_TIME;
+			uint64_t nextOutput = 0;
+			// the target frame was already rendered without blending
+			bool finished = true;
+		} interpolation;
+
+		// the decoded pixels go to the received frame instead of the LED driver
+		struct TargetFrame
+		{
+			ColorDefinition* pixels;
+
+			inline void SetPixel(int index, const ColorDefinition& color)
+			{
+				pixels[index] = color;
+			}
+		};
+	#endif
+	#if defined(DITHERING_RENDER)
+		// the received frame, the displayed frame and the error accumulators of every LED
+		struct
+		{
+			ColorHighPrecision* incoming = nullptr;
+			ColorHighPrecision* current = nullptr;
+			ColorDitheringError* errors = nullptr;
+			// some channel has the fractional part: the frame is sent again whenever the strip is idle
+			bool incomingFractional = false;
+			bool currentFractional = false;
+			// the displayed frame wasn't rendered yet
+			bool pending = false;
+		} dithering;
+
+		// the decoded pixels go to the received frame instead of the LED driver
+		struct TargetFrame
+		{
+			ColorHighPrecision* pixels;
+			bool& fractional;
+
+			inline void SetPixel(int index, const ColorDefinition& color)
+			{
+				ColorHighPrecision& target = pixels[index];
+
+				target.R = color.R << 8;
+				target.G = color.G << 8;
+				target.B = color.B << 8;
+				#if defined(NEOPIXEL_RGBW)
+					target.W = color.W << 8;
+				#endif
+			}
+
+			inline void SetPixel(int index, const ColorHighPrecision& color)
+			{
+				pixels[index] = color;
+
+				#if defined(NEOPIXEL_RGBW)
+					fractional |= ((color.R | color.G | color.B | color.W) & 0xff) != 0;
+				#else
+					fractional |= ((color.R | color.G | color.B) & 0xff) != 0;
+				#endif
+			}
+		};
+	#endif
+
+	#if defined(SEGMENT_INDEXES)
+		/**
+		 * @brief Find the segment that contains the pixel
+		 *
+		 * @param pix
+		 * @return int
+		 */
+		inline int findSegment(int pix)
+		{
+			if (pix < segments[currentSegment].start)
+				currentSegment = 0;
+
+			while (pix >= segments[currentSegment].start + segments[currentSegment].length)
+				currentSegment++;
+
+			return currentSegment;
+		}
+	#endif
 
 	public:
-		// static data buffer for the loop
-		volatile uint8_t buffer[MAX_BUFFER + 1] = {0};
+		#if defined(SEGMENT_INDEXES)
+			Base()
+			{
+				std::copy(std::begin(segmentIndexes), std::end(segmentIndexes), layout.indexes);
+				std::copy(std::begin(segmentsReversed), std::end(segmentsReversed), layout.reversed);
+			}
+		#endif
+
+		// received data: written by core0, parsed by core1
+		RingBuffer<MAX_BUFFER> ring;
 		// handle to tasks
 		TaskHandle_t processDataHandle = nullptr;
 		TaskHandle_t processSerialHandle = nullptr;
-		// semaphore to synchronize them
-		semaphore_t serialSemaphore;
+		// USB callback -> core0 task
 		semaphore_t receiverSemaphore;
-		// current queue position
-		volatile int queueCurrent = 0;
-		// queue end position
-		volatile int queueEnd = 0;
+		// time of the first USB callback that wasn't signaled to core1 yet
+		volatile uint32_t usbCallbackTime = 0;
+		volatile bool usbCallbackPending = false;
+
+		/**
+		 * @brief The USB callback (core0): remember the time of the first one for the wake-up latency
+		 *
+		 */
+		inline void onUsbCallback()
+		{
+			if (!usbCallbackPending)
+			{
+				usbCallbackTime = time_us_32();
+				usbCallbackPending = true;
+			}
+		}
+
+		/**
+		 * @brief core0: new data is in the buffer, wake up core1 through the inter-core FIFO.
+		 *        The doorbell carries the time of the USB callback. A full FIFO means that core1
+		 *        has the doorbells to process anyway, so nothing is lost when it's skipped.
+		 *
+		 */
+		inline void ringDoorbell()
+		{
+			uint32_t callbackTime = (usbCallbackPending) ? usbCallbackTime : time_us_32();
+
+			usbCallbackPending = false;
+
+			if (multicore_fifo_wready())
+				multicore_fifo_push_blocking(callbackTime);
+		}
+
+		/**
+		 * @brief core1: wait for the doorbell and measure the latency from the USB callback.
+		 *        All pending doorbells are consumed: the parser processes all received data at once.
+		 *
+		 * @param timeout_us 0: wait forever
+		 * @return true if woken up by the doorbell
+		 */
+		inline bool waitForDoorbell(uint32_t timeout_us)
+		{
+			uint32_t callbackTime;
+
+			if (timeout_us == 0)
+				callbackTime = multicore_fifo_pop_blocking();
+			else if (!multicore_fifo_pop_timeout_us(timeout_us, &callbackTime))
+				return false;
+
+			while (multicore_fifo_rvalid())
+				multicore_fifo_pop_blocking();
+
+			statistics.addWakeUpLatency(time_us_32() - callbackTime);
+			return true;
+		}
 
 		inline int getLedsNumber()
 		{
@@ -63,51 +381,132 @@ class Base
 			return ledStrip1;
 		}
 
-		inline LED_DRIVER2* getLedStrip2()
-		{
-			return ledStrip2;
-		}
-
 		void initLedStrip(int count)
 		{
-			if (ledStrip1 != nullptr)
-			{
-				delete ledStrip1;
-				ledStrip1 = nullptr;
-			}
+			DmaClient::frameTransferred = onFrameTransferred;
 
-			if (ledStrip2 != nullptr)
-			{
-				delete ledStrip2;
-				ledStrip2 = nullptr;
-			}
+			#if defined(RENDER_SCHEDULER)
+				// the first strip: the alarm IRQ is handled by this core (core1) as the DMA IRQ
+				if (renderAlarm < 0)
+				{
+					renderAlarm = hardware_alarm_claim_unused(true);
+					renderScheduler = this;
+					hardware_alarm_set_callback(renderAlarm, onRenderAlarm);
+					DmaClient::transferFinished = onTransferFinished;
+				}
 
+				uint32_t irqState = save_and_disable_interrupts();
+				hardware_alarm_cancel(renderAlarm);
+				readyToRender = false;
+				restore_interrupts(irqState);
+			#endif
+
+			#if defined(SEGMENT_INDEXES)
+				for (int i = segmentsNumber - 1; i >= 0; i--)
+					delete segments[i].strip;
+
+				segmentsNumber = 0;
+				currentSegment = 0;
+			#else
+				delete ledStrip1;
+			#endif
+
+			ledStrip1 = nullptr;
 			ledsNumber = count;
 
-			#if defined(SECOND_SEGMENT_START_INDEX)
-				if (ledsNumber > SECOND_SEGMENT_START_INDEX)
+			#if defined(SEGMENT_INDEXES)
+				// parallel lanes on the consecutive GPIOs starting from DATA_PIN
+				for (int i = 0; i < layout.segments; i++)
 				{
-					#if defined(NEOPIXEL_RGBW) || defined(NEOPIXEL_RGB)
-						ledStrip1 = new LED_DRIVER(SECOND_SEGMENT_START_INDEX, DATA_PIN);
-						ledStrip2 = new LED_DRIVER2(ledsNumber - SECOND_SEGMENT_START_INDEX, DATA_PIN);
+					#if defined(SEGMENTS_INTERLEAVED)
+						// the host sends the pixels of the segments interleaved, so they have equal length
+						int lanes = std::max(std::min(layout.segments, ledsNumber), 1);
+						int start = i;
+						int length = (ledsNumber - i + lanes - 1) / lanes;
 					#else
-						ledStrip1 = new LED_DRIVER(SECOND_SEGMENT_START_INDEX);
-						ledStrip1->Begin(CLOCK_PIN, 12, DATA_PIN, 15);
-						ledStrip2 = new LED_DRIVER2(ledsNumber - SECOND_SEGMENT_START_INDEX);
-						ledStrip2->Begin(SECOND_SEGMENT_CLOCK_PIN, 12, SECOND_SEGMENT_DATA_PIN, 15);
+						int start = (i == 0) ? 0 : layout.indexes[i - 1];
+						int length = ((i + 1 < layout.segments) ? std::min(layout.indexes[i], ledsNumber) : ledsNumber) - start;
 					#endif
+
+					if (length <= 0 && i > 0)
+						break;
+
+					segments[i].strip = new LED_DRIVER(length, DATA_PIN);
+					segments[i].start = start;
+					segments[i].length = length;
+					segments[i].reversed = layout.reversed[i];
+					segmentsNumber++;
+				}
+
+				ledStrip1 = segments[0].strip;
+			#elif defined(NEOPIXEL_RGBW) || defined(NEOPIXEL_RGB)
+				ledStrip1 = new LED_DRIVER(ledsNumber, DATA_PIN);
+			#else
+				ledStrip1 = new LED_DRIVER(ledsNumber, SPI_INTERFACE, DATA_PIN, CLOCK_PIN);
+			#endif
+
+			statistics.setBufferSwapSaving(ledStrip1->getBufferSwapSaving());
+
+			#if defined(INTERPOLATION_RENDER)
+				for (auto frame : { &interpolation.incoming, &interpolation.current, &interpolation.previous })
+				{
+					delete[] *frame;
+					*frame = new ColorDefinition[ledsNumber];
 				}
+
+				interpolation.arrival = 0;
+				interpolation.finished = true;
 			#endif
 
-			if (ledStrip1 == nullptr)
+			#if defined(DITHERING_RENDER)
+				delete[] dithering.incoming;
+				delete[] dithering.current;
+				delete[] dithering.errors;
+				dithering.incoming = new ColorHighPrecision[ledsNumber]();
+				dithering.current = new ColorHighPrecision[ledsNumber]();
+				dithering.errors = new ColorDitheringError[ledsNumber]();
+
+				dithering.incomingFractional = false;
+				dithering.currentFractional = false;
+				dithering.pending = false;
+			#endif
+		}
+
+		#if defined(SEGMENT_INDEXES)
+			/**
+			 * @brief Set new segments layout and rebuild the parallel drivers.
+			 *        In the interleaved mode only the number of segments is used.
+			 *
+			 * @param segmentsCount number of the segments (lanes)
+			 * @param indexes starting indexes of the 2nd, 3rd... segment
+			 * @param reversedMask bit 'n' is set if segment 'n' is reversed
+			 * @return true if the layout is valid and was applied
+			 */
+			bool setSegmentsLayout(int segmentsCount, const uint16_t* indexes, uint8_t reversedMask)
 			{
-				#if defined(NEOPIXEL_RGBW) || defined(NEOPIXEL_RGB)
-					ledStrip1 = new LED_DRIVER(ledsNumber, DATA_PIN);
-				#else
-					ledStrip1 = new LED_DRIVER(ledsNumber, SPI_INTERFACE, DATA_PIN, CLOCK_PIN);
+				if (segmentsCount < 1 || segmentsCount > MAX_SEGMENTS)
+					return false;
+
+				#if !defined(SEGMENTS_INTERLEAVED)
+					for (int i = 0; i < segmentsCount - 1; i++)
+						if (indexes[i] == 0 || (i > 0 && indexes[i] <= indexes[i - 1]))
+							return false;
 				#endif
+
+				layout.segments = segmentsCount;
+
+				for (int i = 0; i < segmentsCount - 1; i++)
+					layout.indexes[i] = indexes[i];
+
+				for (int i = 0; i < MAX_SEGMENTS; i++)
+					layout.reversed[i] = (reversedMask >> i) & 1;
+
+				if (ledsNumber > 0)
+					initLedStrip(ledsNumber);
+
+				return true;
 			}
-		}
+		#endif
 
 		/**
 		 * @brief Check if there is already prepared frame to display
@@ -117,55 +516,471 @@ class Base
 		 */
 		inline bool hasLateFrameToRender()
 		{
-			return readyToRender;
+			#if defined(INTERPOLATION_RENDER)
+				return !interpolation.finished;
+			#elif defined(DITHERING_RENDER)
+				return dithering.pending || dithering.currentFractional;
+			#else
+				return readyToRender;
+			#endif
 		}
 
 		inline void dropLateFrame()
 		{
-			readyToRender = false;
+			#if defined(RENDER_SCHEDULER)
+				// the alarm could submit it meanwhile
+				uint32_t irqState = save_and_disable_interrupts();
+
+				if (readyToRender)
+					statistics.increaseDroppedLate();
+
+				readyToRender = false;
+				restore_interrupts(irqState);
+			#else
+				readyToRender = false;
+			#endif
+			#if defined(STREAMING_RENDER)
+				repairFrame = false;
+			#endif
+		}
+
+		/**
+		 * @brief New frame starts to arrive. The delta frame needs the last good frame in the composing buffer:
+		 *        restore it from the DMA buffer unless it's still there.
+		 *
+		 * @param delta
+		 */
+		inline void beginFrame(bool delta)
+		{
+			PROFILE_SCOPE_IF(frameCopy, delta);
+
+			#if defined(INTERPOLATION_RENDER)
+				if (delta)
+					std::copy(interpolation.current, interpolation.current + ledsNumber, interpolation.incoming);
+			#elif defined(DITHERING_RENDER)
+				if (delta)
+					std::copy(dithering.current, dithering.current + ledsNumber, dithering.incoming);
+
+				dithering.incomingFractional = delta && dithering.currentFractional;
+			#else
+				if (delta && !composedFrameIsLast)
+					ledStrip1->restoreLastFrame();
+
+				composedFrameIsLast = false;
+			#endif
+
+			#if defined(STREAMING_RENDER)
+				streamLatched = false;
+			#endif
+		}
+
+		/**
+		 * @brief Streaming render: start/continue sending the frame once the first STREAMING_RENDER pixels are decoded
+		 *
+		 * @param decodedLeds number of the decoded pixels of the current frame
+		 */
+		inline void streamPixels(int decodedLeds)
+		{
+			#if defined(STREAMING_RENDER)
+				if (!streaming)
+				{
+					if (streamLatched || decodedLeds < std::min(STREAMING_RENDER, ledsNumber) || !ledStrip1->isReady())
+						return;
+
+					ledStrip1->streamBegin();
+					statistics.markFrameStreamed();
+					streaming = true;
+				}
+
+				switch (ledStrip1->streamCommit(decodedLeds))
+				{
+				case StreamCommit::underrun:
+					statistics.increaseStreamUnderrun();
+					break;
+
+				case StreamCommit::latched:
+					// the DMA was idle longer than the reset time: resuming would shift the rest of the frame to the first LED
+					streaming = false;
+					streamLatched = true;
+					statistics.increaseStreamLatched();
+					break;
+
+				default:
+					break;
+				}
+			#endif
+		}
+
+		#if defined(STREAMING_RENDER)
+			inline bool isStreaming()
+			{
+				return streaming;
+			}
+		#endif
+
+		/**
+		 * @brief The frame is broken (e.g. checksum failure): if it was already partially sent,
+		 *        stop the stream and send again the last good frame
+		 *
+		 */
+		inline void abortStream()
+		{
+			#if defined(STREAMING_RENDER)
+				if (streaming || streamLatched)
+				{
+					if (streaming)
+						ledStrip1->streamAbort();
+
+					streaming = false;
+					streamLatched = false;
+					statistics.increaseStreamRepair();
+
+					repairFrame = true;
+					readyToRender = true;
+					renderLeds(false);
+				}
+			#endif
+		}
+
+		#if defined(INTERPOLATION_RENDER)
+			/**
+			 * @brief Weight of the target frame in the transition
+			 *
+			 * @param now
+			 * @return uint32_t 0-256
+			 */
+			inline uint32_t getInterpolationWeight(uint64_t now)
+			{
+				uint64_t elapsed = now - interpolation.arrival;
+
+				return (elapsed >= interpolation.duration) ? 256 : (uint32_t)(elapsed * 256 / interpolation.duration);
+			}
+
+			/**
+			 * @brief The received frame becomes the new target. The transition starts from the currently displayed blend,
+			 *        so the frame that arrives early doesn't make a jump.
+			 *
+			 */
+			inline void setInterpolationTarget()
+			{
+				uint64_t now = time_us_64();
+				uint32_t weight = getInterpolationWeight(now);
+
+				if (weight < 256)
+				{
+					for (int i = 0; i < ledsNumber; i++)
+						interpolation.previous[i] = blendColor(interpolation.previous[i], interpolation.current[i], weight);
+				}
+				else
+					std::swap(interpolation.previous, interpolation.current);
+
+				std::swap(interpolation.current, interpolation.incoming);
+
+				interpolation.duration = std::clamp(now - interpolation.arrival, (uint64_t)INTERPOLATION_PERIOD, (uint64_t)INTERPOLATION_MAX_TIME);
+				interpolation.arrival = now;
+				interpolation.finished = false;
+			}
+
+			/**
+			 * @brief Render the blend of the previous and the target frame at the fixed output rate.
+			 *        The output tick is skipped if the strip is still busy (the wire time limit).
+			 *
+			 */
+			inline void renderInterpolated()
+			{
+				uint64_t now = time_us_64();
+
+				if (interpolation.finished || now < interpolation.nextOutput || !ledStrip1->isReady())
+					return;
+
+				interpolation.nextOutput += INTERPOLATION_PERIOD;
+				if (interpolation.nextOutput <= now)
+					interpolation.nextOutput = now + INTERPOLATION_PERIOD;
+
+				uint32_t weight = getInterpolationWeight(now);
+				const ColorDefinition* from = interpolation.previous;
+				const ColorDefinition* to = interpolation.current;
+
+				// the runs of the segments come in the frame order
+				mapStripPixels(0, ledsNumber, [&](auto* strip, int index, int step, int leds)
+				{
+					for (; leds > 0; leds--, index += step)
+						strip->SetPixel(index, blendColor(*(from++), *(to++), weight));
+				});
+
+				interpolation.finished = (weight == 256);
+				statistics.increaseShow();
+				statistics.markFrameSubmitted();
+
+				#if defined(SEGMENT_INDEXES)
+					ledStrip1->renderAllLanes();
+				#else
+					ledStrip1->renderSingleLane();
+				#endif
+			}
+		#endif
+
+		#if defined(DITHERING_RENDER)
+			/**
+			 * @brief Render the dithered frame. The new frame waits for the strip,
+			 *        the frame with the fractional parts is sent again only if the strip is idle.
+			 *
+			 */
+			inline void renderDithered()
+			{
+				if (!dithering.pending && !dithering.currentFractional)
+					return;
+
+				if (!((dithering.pending) ? ledStrip1->isReadyBlocking() : ledStrip1->isReady()))
+					return;
+
+				const ColorHighPrecision* color = dithering.current;
+				ColorDitheringError* error = dithering.errors;
+
+				// the runs of the segments come in the frame order
+				mapStripPixels(0, ledsNumber, [&](auto* strip, int index, int step, int leds)
+				{
+					for (; leds > 0; leds--, index += step)
+						strip->SetPixel(index, ditherColor(*(color++), *(error++)));
+				});
+
+				if (dithering.pending)
+					statistics.increaseShow();
+				else
+					statistics.increaseDithered();
+
+				dithering.pending = false;
+				statistics.markFrameSubmitted();
+
+				#if defined(SEGMENT_INDEXES)
+					ledStrip1->renderAllLanes();
+				#else
+					ledStrip1->renderSingleLane();
+				#endif
+			}
+		#endif
+
+		static void onFrameTransferred(uint64_t start, uint64_t end)
+		{
+			statistics.addFrameTransfer(start, end);
 		}
 
+		#if defined(RENDER_SCHEDULER)
+			static void onTransferFinished()
+			{
+				renderScheduler->scheduleRender();
+			}
+
+			static void onRenderAlarm(uint)
+			{
+				renderScheduler->scheduleRender();
+			}
+
+			/**
+			 * @brief Submit the waiting frame if the strip is idle and its latch time and the frame pacing allow it,
+			 *        otherwise set the alarm to that time. If the strip is still busy the DMA IRQ calls it again.
+			 *        Called by the parser, from the DMA IRQ and from the alarm IRQ: it never blocks.
+			 *
+			 */
+			void scheduleRender()
+			{
+				uint32_t irqState = save_and_disable_interrupts();
+
+				if (readyToRender && ledStrip1 != nullptr && ledStrip1->isReady())
+				{
+					uint64_t start = ledStrip1->getLatchEnd();
+
+					#if defined(FRAME_PACING)
+						start = std::max(start, nextFrameTime);
+					#endif
+
+					if (time_us_64() >= start || hardware_alarm_set_target(renderAlarm, from_us_since_boot(start)))
+					{
+						readyToRender = false;
+						composedFrameIsLast = false;
+						statistics.increaseShow();
+						statistics.markFrameSubmitted();
+
+						#if defined(FRAME_PACING)
+							// keep the even spacing unless the output was idle for longer than one period
+							uint64_t now = time_us_64();
+							nextFrameTime = (now < nextFrameTime + FRAME_PACING_PERIOD) ? nextFrameTime + FRAME_PACING_PERIOD : now + FRAME_PACING_PERIOD;
+						#endif
+
+						#if defined(SEGMENT_INDEXES)
+							ledStrip1->renderAllLanes();
+						#else
+							ledStrip1->renderSingleLane();
+						#endif
+					}
+				}
+
+				restore_interrupts(irqState);
+			}
+		#endif
+
 		inline void renderLeds(bool newFrame)
 		{
+			#if defined(RENDER_SCHEDULER)
+				if (newFrame)
+				{
+					readyToRender = true;
+					composedFrameIsLast = true;
+				}
+
+				scheduleRender();
+				return;
+			#endif
+
+			#if defined(DITHERING_RENDER)
+				if (newFrame)
+				{
+					std::swap(dithering.current, dithering.incoming);
+					dithering.currentFractional = dithering.incomingFractional;
+					dithering.pending = true;
+				}
+
+				if (ledStrip1 != nullptr)
+					renderDithered();
+				return;
+			#endif
+
+			#if defined(INTERPOLATION_RENDER)
+				if (newFrame)
+					setInterpolationTarget();
+
+				if (ledStrip1 != nullptr)
+					renderInterpolated();
+				return;
+			#endif
+
+			#if defined(STREAMING_RENDER)
+				if (newFrame && streaming)
+				{
+					streaming = false;
+
+					if (ledStrip1->streamFinish())
+					{
+						dropLateFrame();
+						composedFrameIsLast = false;
+						statistics.increaseShow();
+						statistics.increaseStreamed();
+						return;
+					}
+
+					// the LEDs have latched the partial frame while the checksums were arriving: send the whole frame
+					statistics.increaseStreamLatched();
+				}
+
+				if (newFrame)
+					streamLatched = false;
+			#endif
+
 			if (newFrame)
+			{
 				readyToRender = true;
+				composedFrameIsLast = true;
+			}
 
 			if (readyToRender &&
 				(ledStrip1 != nullptr && ledStrip1->isReadyBlocking()))
 			{
 				statistics.increaseShow();
+				statistics.markFrameSubmitted();
 				readyToRender = false;
+				composedFrameIsLast = false;
 
 				// display segments
-				#if defined(SECOND_SEGMENT_START_INDEX)
+				#if defined(SEGMENT_INDEXES)
 					ledStrip1->renderAllLanes();
+				#elif defined(STREAMING_RENDER)
+					ledStrip1->renderSingleLane(!repairFrame);
+					repairFrame = false;
 				#else
 					ledStrip1->renderSingleLane();
 				#endif
 			}
 		}
 
-		inline bool setStripPixel(uint16_t pix, ColorDefinition &inputColor)
+		/**
+		 * @brief Split a run of pixels between the segments. The decoder is called once per segment
+		 *        as decoder(strip, firstIndex, indexStep, pixels). The run must fit in the strip.
+		 *
+		 * @param pix
+		 * @param pixels
+		 * @param decoder
+		 */
+		template<typename Decoder>
+		inline void mapStripPixels(uint16_t pix, int pixels, Decoder&& decoder)
 		{
-			if (pix < ledsNumber)
-			{
-				#if defined(SECOND_SEGMENT_START_INDEX)
-					if (pix < SECOND_SEGMENT_START_INDEX)
-						ledStrip1->SetPixel(pix, inputColor);
-					else
+			#if defined(SEGMENT_INDEXES) && defined(SEGMENTS_INTERLEAVED)
+				int lane = pix % segmentsNumber;
+				int index = pix / segmentsNumber;
+
+				for (; pixels > 0; pixels--)
+				{
+					auto& segment = segments[lane];
+
+					decoder(segment.strip, (segment.reversed) ? segment.length - index - 1 : index, 1, 1);
+
+					if (++lane == segmentsNumber)
 					{
-						#if defined(SECOND_SEGMENT_REVERSED)
-							ledStrip2->SetPixel(ledsNumber - pix - 1, inputColor);
-						#else
-							ledStrip2->SetPixel(pix - SECOND_SEGMENT_START_INDEX, inputColor);
-						#endif
+						lane = 0;
+						index++;
 					}
-				#else
-					ledStrip1->SetPixel(pix, inputColor);
-				#endif
-			}
+				}
+			#elif defined(SEGMENT_INDEXES)
+				for (int i = findSegment(pix); pixels > 0; i++)
+				{
+					auto& segment = segments[i];
+					int leds = std::min(pixels, segment.start + segment.length - pix);
+					int index = pix - segment.start;
 
-			return (pix + 1 < ledsNumber);
+					if (segment.reversed)
+						decoder(segment.strip, segment.length - index - 1, -1, leds);
+					else
+						decoder(segment.strip, index, 1, leds);
+
+					currentSegment = i;
+					pix += leds;
+					pixels -= leds;
+				}
+			#else
+				decoder(ledStrip1, pix, 1, pixels);
+			#endif
+		}
+
+		/**
+		 * @brief Set a run of the decoded pixels: to the LED driver or, if the frames are interpolated or dithered,
+		 *        to the received frame. The decoder is called as decoder(strip, firstIndex, indexStep, pixels).
+		 *
+		 * @param pix
+		 * @param pixels
+		 * @param decoder
+		 */
+		template<typename Decoder>
+		inline void setStripPixels(uint16_t pix, int pixels, Decoder&& decoder)
+		{
+			#if defined(INTERPOLATION_RENDER)
+				TargetFrame target{ interpolation.incoming };
+				decoder(&target, pix, 1, pixels);
+			#elif defined(DITHERING_RENDER)
+				TargetFrame target{ dithering.incoming, dithering.incomingFractional };
+				decoder(&target, pix, 1, pixels);
+			#else
+				mapStripPixels(pix, pixels, std::forward<Decoder>(decoder));
+			#endif
+		}
+
+		inline void setStripPixel(uint16_t pix, ColorDefinition &inputColor)
+		{
+			if (pix < ledsNumber)
+			{
+				setStripPixels(pix, 1, [&](auto* strip, int index, int, int)
+				{
+					strip->SetPixel(index, inputColor);
+				});
+			}
 		}
 } base;
 
@@ -28,7 +28,7 @@
 #ifdef NEOPIXEL_RGBW
 	typedef ColorGrbw ColorDefinition;
 #elif NEOPIXEL_RGB
-	#if defined(SECOND_SEGMENT_START_INDEX)
+	#if defined(SEGMENT_INDEXES) && !defined(SEGMENTS_INDEPENDENT)
 		typedef ColorGrb ColorDefinition;
 	#else
 		typedef ColorGrb32 ColorDefinition;
@@ -122,14 +122,19 @@ class CalibrationConfig
 		}
 
 		/**
-		 * @brief print RGBW calibration parameters when no data is received
+		 * @brief Get the parameters of RGB to RGBW transformation
 		 *
+		 * @param _gain [out]
+		 * @param _red [out]
+		 * @param _green [out]
+		 * @param _blue [out]
 		 */
-		void printCalibration()
+		void getParams(uint8_t& _gain, uint8_t& _red, uint8_t& _green, uint8_t& _blue)
 		{
-			char output[128];
-			snprintf(output, sizeof(output),"RGBW => Gain: %i/255, red: %i, green: %i, blue: %i\r\n", gain, red, green, blue);
-			printf(output);
+			_gain = gain;
+			_red = red;
+			_green = green;
+			_blue = blue;
 		}
 } calibrationConfig;
 
@@ -0,0 +1,150 @@
+/* colorlut.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+
+#ifndef COLORLUT_H
+#define COLORLUT_H
+
+// control frame payload: the red, green and blue tables
+#define COLOR_LUT_CHANNELS 3
+#define COLOR_LUT_SIZE (COLOR_LUT_CHANNELS * 256)
+
+/**
+ * @brief Look up the 8.8 fixed point value: the table is interpolated between its entries
+ *
+ * @param lut
+ * @param value
+ * @return uint16_t 8.8 fixed point
+ */
+static inline uint16_t lookupHighPrecision(const uint8_t* lut, uint16_t value)
+{
+	int index = value >> 8;
+	int next = lut[std::min(index + 1, 255)];
+
+	return (lut[index] << 8) + (next - lut[index]) * (value & 0xff);
+}
+
+/**
+ * @brief Per-channel correction tables (e.g. gamma and white balance) uploaded by the host.
+ *        The pixel decoder reads the active tables, the upload goes to the inactive ones
+ *        and they are swapped after the checksum of the control frame is verified.
+ *
+ */
+class
+{
+	uint8_t tables[2][COLOR_LUT_CHANNELS][256];
+	uint8_t active = 0;
+	bool enabled = false;
+	int received = 0;
+	uint32_t uploads = 0;
+
+	public:
+		/**
+		 * @brief The tables are applied only if they are not the identity
+		 *
+		 * @return true
+		 * @return false
+		 */
+		inline bool isEnabled() const
+		{
+			return enabled;
+		}
+
+		/**
+		 * @brief Correct the channel value
+		 *
+		 * @tparam correction the tables are enabled
+		 * @param channel 0: red, 1: green, 2: blue
+		 * @param value
+		 * @return uint8_t
+		 */
+		template<bool correction>
+		inline uint8_t correct(int channel, uint8_t value) const
+		{
+			return (correction) ? tables[active][channel][value] : value;
+		}
+
+		/**
+		 * @brief Correct the 8.8 fixed point channel value of the high precision frame
+		 *
+		 * @param channel 0: red, 1: green, 2: blue
+		 * @param value
+		 * @return uint16_t
+		 */
+		inline uint16_t correctHighPrecision(int channel, uint16_t value) const
+		{
+			return (enabled) ? lookupHighPrecision(tables[active][channel], value) : value;
+		}
+
+		/**
+		 * @brief New control frame with the tables starts to arrive
+		 *
+		 */
+		inline void beginUpload()
+		{
+			received = 0;
+		}
+
+		/**
+		 * @brief Store the next byte of the uploaded tables
+		 *
+		 * @param input
+		 * @return true if all tables were received
+		 */
+		inline bool addUpload(uint8_t input)
+		{
+			tables[active ^ 1][received / 256][received % 256] = input;
+			return ++received == COLOR_LUT_SIZE;
+		}
+
+		/**
+		 * @brief The uploaded tables were verified: they replace the active ones from the next pixel
+		 *
+		 */
+		inline void commitUpload()
+		{
+			active ^= 1;
+			enabled = false;
+			uploads++;
+
+			for (int channel = 0; channel < COLOR_LUT_CHANNELS; channel++)
+				for (int i = 0; i < 256; i++)
+					enabled |= tables[active][channel][i] != i;
+		}
+
+		/**
+		 * @brief Count of the verified uploads
+		 *
+		 * @return uint32_t
+		 */
+		inline uint32_t getUploads()
+		{
+			return uploads;
+		}
+} colorLut;
+
+#endif
@@ -28,6 +28,14 @@
 #ifndef FRAMESTATE_H
 #define FRAMESTATE_H
 
+// max. number of bytes for the Fletcher span kernel before the sums must be reduced (no 32-bit overflow)
+#define FLETCHER_BLOCK 5552
+
+// compressed frame: max. number of the palette colors and the tokens (literal: 0x00-0x7f, run: 0x80-0xbf, palette: 0xc0-0xff)
+#define COMPRESSED_PALETTE_COLORS 64
+#define COMPRESSED_TOKEN_RUN 0x80
+#define COMPRESSED_TOKEN_INDEXES 0xc0
+
 /**
  * @brief my AWA frame protocol definition
  *
@@ -51,7 +59,20 @@ enum class AwaProtocol
 	EXTRA_COLOR_BYTE_4,	
 	FLETCHER1,
 	FLETCHER2,
-	FLETCHER_EXT
+	FLETCHER_EXT,
+	SEGMENTS_LANES,
+	SEGMENTS_DATA,
+	DELTA_OFFSET_HI,
+	DELTA_OFFSET_LO,
+	DELTA_LENGTH_HI,
+	DELTA_LENGTH_LO,
+	COMPRESSED_PALETTE_SIZE,
+	COMPRESSED_PALETTE,
+	COMPRESSED_TOKEN,
+	COMPRESSED_RUN_COLOR,
+	COMPRESSED_INDEX,
+	HIGH_PRECISION_PIXEL,
+	COLOR_LUT_DATA
 };
 
 /**
@@ -63,18 +84,53 @@ class
 	volatile AwaProtocol state = AwaProtocol::HEADER_A;
 	bool protocolVersion2 = false;
 	bool protocolVersion3 = false;	
+	bool deltaFrame = false;
+	bool compressedFrame = false;
+	bool highPrecisionFrame = false;
 	uint8_t CRC = 0;
 	uint16_t count = 0;
 	uint16_t currentLed = 0;
+	// end of the current run of pixels: the whole strip or the delta frame range
+	uint16_t rangeEnd = 0;
 	uint16_t fletcher1 = 0;
 	uint16_t fletcher2 = 0;
 	uint16_t fletcherExt = 0;
 	uint8_t position = 0;
 	bool regroup = false;
+	bool segmentsLayoutFrame = false;
+	bool colorLutFrame = false;
 
 	public:
 		ColorDefinition color;
 
+		// delta frame: the range header that is being received
+		struct
+		{
+			uint16_t offset;
+			uint16_t length;
+		} deltaRange;
+
+		// compressed frame: the palette (already converted colors) and the token that is being received
+		struct
+		{
+			ColorDefinition palette[COMPRESSED_PALETTE_COLORS];
+			int paletteSize;
+			int received;
+			int pixels;
+			uint8_t colorBytes[4];
+		} compressed;
+
+		#if defined(DITHERING_RENDER)
+			// high precision frame: the decoded color and the bytes of the pixel that is being received (16-bit R, G, B)
+			ColorHighPrecision highPrecisionColor;
+
+			struct
+			{
+				uint8_t colorBytes[6];
+				int received;
+			} highPrecision;
+		#endif
+
 		/**
 		 * @brief Reset statistics for new frame
 		 *
@@ -83,12 +139,15 @@ class
 		inline void init(uint8_t input)
 		{
 			currentLed = 0;
+			rangeEnd = 0;
 			count = input * 0x100;
 			CRC = input;
 			fletcher1 = 0;
 			fletcher2 = 0;
 			fletcherExt = 0;
 			position = 0;
+			segmentsLayoutFrame = false;
+			colorLutFrame = false;
 			base.dropLateFrame();
 		}
 
@@ -152,6 +211,61 @@ class
 			return currentLed++;
 		}
 
+		/**
+		 * @brief Get the number of Leds that are still expected in the current frame
+		 *
+		 * @return int
+		 */
+		inline int getRemainingLeds()
+		{
+			return rangeEnd - currentLed;
+		}
+
+		/**
+		 * @brief Get the number of Leds that are still expected in the whole frame
+		 *
+		 * @return int
+		 */
+		inline int getFrameRemainingLeds()
+		{
+			return count + 1 - currentLed;
+		}
+
+		/**
+		 * @brief Set the run of pixels that comes next: the whole strip or the delta frame range
+		 *
+		 * @param offset index of the first pixel
+		 * @param length
+		 */
+		inline void startRange(uint16_t offset, uint16_t length)
+		{
+			currentLed = offset;
+			rangeEnd = offset + length;
+		}
+
+		/**
+		 * @brief Get the number of Leds that were already decoded in the current frame
+		 *
+		 * @return int
+		 */
+		inline int getDecodedLeds()
+		{
+			return currentLed;
+		}
+
+		/**
+		 * @brief Get the current Led index and move it forward by the number of decoded Leds
+		 *
+		 * @param leds
+		 * @return uint16_t
+		 */
+		inline uint16_t advanceLedIndex(int leds)
+		{
+			uint16_t index = currentLed;
+			currentLed += leds;
+			return index;
+		}
+
 		/**
 		 * @brief Set if frame protocol version 2 (contains calibration data)
 		 *
@@ -194,6 +308,69 @@ class
 			return protocolVersion3;
 		}		
 
+		/**
+		 * @brief Set if the frame is the delta frame (only the ranges of the pixels that changed)
+		 *
+		 * @param newValue
+		 */
+		inline void setDeltaFrame(bool newValue)
+		{
+			deltaFrame = newValue;
+		}
+
+		/**
+		 * @brief Verify if the frame is the delta frame (only the ranges of the pixels that changed)
+		 *
+		 * @return true
+		 * @return false
+		 */
+		inline bool isDeltaFrame() const
+		{
+			return deltaFrame;
+		}
+
+		/**
+		 * @brief Set if the frame is compressed (runs of the same color and the palette)
+		 *
+		 * @param newValue
+		 */
+		inline void setCompressedFrame(bool newValue)
+		{
+			compressedFrame = newValue;
+		}
+
+		/**
+		 * @brief Verify if the frame is compressed (runs of the same color and the palette)
+		 *
+		 * @return true
+		 * @return false
+		 */
+		inline bool isCompressedFrame() const
+		{
+			return compressedFrame;
+		}
+
+		/**
+		 * @brief Set if the frame has 16-bit channels (dithered by the device)
+		 *
+		 * @param newValue
+		 */
+		inline void setHighPrecisionFrame(bool newValue)
+		{
+			highPrecisionFrame = newValue;
+		}
+
+		/**
+		 * @brief Verify if the frame has 16-bit channels (dithered by the device)
+		 *
+		 * @return true
+		 * @return false
+		 */
+		inline bool isHighPrecisionFrame() const
+		{
+			return highPrecisionFrame;
+		}
+
 		/**
 		 * @brief  Set new AWA frame state
 		 *
@@ -237,6 +414,102 @@ class
 			fletcherExt = (fletcherExt + (input ^ (position++))) % 255;
 		}
 
+		/**
+		 * @brief Update Fletcher checksum for the span of the incoming input.
+		 *        Modulo reductions are deferred to the end of every block, results are identical to the byte-wise version.
+		 *
+		 * @param input
+		 * @param len
+		 */
+		inline void addFletcher(const volatile uint8_t* input, int len)
+		{
+			PROFILE_SCOPE(fletcher);
+
+			uint32_t sum1 = fletcher1;
+			uint32_t sum2 = fletcher2;
+			uint32_t sumExt = fletcherExt;
+			uint8_t pos = position;
+
+			while (len > 0)
+			{
+				int block = std::min(len, FLETCHER_BLOCK);
+				len -= block;
+
+				for (; block >= 4; block -= 4, input += 4, pos += 4)
+				{
+					uint8_t a = input[0], b = input[1], c = input[2], d = input[3];
+					sum1 += a;
+					sum2 += sum1;
+					sum1 += b;
+					sum2 += sum1;
+					sum1 += c;
+					sum2 += sum1;
+					sum1 += d;
+					sum2 += sum1;
+					sumExt += (a ^ pos) + (b ^ (uint8_t)(pos + 1)) + (c ^ (uint8_t)(pos + 2)) + (d ^ (uint8_t)(pos + 3));
+				}
+
+				for (; block > 0; block--)
+				{
+					uint8_t a = *(input++);
+					sum1 += a;
+					sum2 += sum1;
+					sumExt += a ^ (pos++);
+				}
+
+				sum1 %= 255;
+				sum2 %= 255;
+				sumExt %= 255;
+			}
+
+			fletcher1 = sum1;
+			fletcher2 = sum2;
+			fletcherExt = sumExt;
+			position = pos;
+		}
+
+		/**
+		 * @brief Set if the current frame is the segments layout control frame
+		 *
+		 * @param newValue
+		 */
+		inline void setSegmentsLayoutFrame(bool newValue)
+		{
+			segmentsLayoutFrame = newValue;
+		}
+
+		/**
+		 * @brief Verify if the current frame is the segments layout control frame
+		 *
+		 * @return true
+		 * @return false
+		 */
+		inline bool isSegmentsLayoutFrame()
+		{
+			return segmentsLayoutFrame;
+		}
+
+		/**
+		 * @brief Set if the current frame is the color LUT control frame
+		 *
+		 * @param newValue
+		 */
+		inline void setColorLutFrame(bool newValue)
+		{
+			colorLutFrame = newValue;
+		}
+
+		/**
+		 * @brief Verify if the current frame is the color LUT control frame
+		 *
+		 * @return true
+		 * @return false
+		 */
+		inline bool isColorLutFrame()
+		{
+			return colorLutFrame;
+		}
+
 		void setRegroup(bool newValue)
 		{
 			regroup = newValue;
@@ -269,6 +542,8 @@ class
 			*/
 			inline void rgb2rgbw()
 			{
+				PROFILE_SCOPE(rgb2rgbw);
+
 				color.W = std::min(channelCorrection.red[color.R],
 								std::min(channelCorrection.green[color.G],
 									channelCorrection.blue[color.B]));
@@ -277,6 +552,60 @@ class
 				color.B -= channelCorrection.blue[color.W];
 				color.W = channelCorrection.white[color.W];
 			}
+
+			#if defined(DITHERING_RENDER)
+				/**
+				* @brief Compute && correct the white channel of the high precision color, as rgb2rgbw
+				*
+				*/
+				inline void rgb2rgbwHighPrecision()
+				{
+					PROFILE_SCOPE(rgb2rgbw);
+
+					ColorHighPrecision& color = highPrecisionColor;
+
+					color.W = std::min(lookupHighPrecision(channelCorrection.red, color.R),
+								std::min(lookupHighPrecision(channelCorrection.green, color.G),
+									lookupHighPrecision(channelCorrection.blue, color.B)));
+					color.R -= lookupHighPrecision(channelCorrection.red, color.W);
+					color.G -= lookupHighPrecision(channelCorrection.green, color.W);
+					color.B -= lookupHighPrecision(channelCorrection.blue, color.W);
+					color.W = lookupHighPrecision(channelCorrection.white, color.W);
+				}
+			#endif
+		#endif
+
+		#if defined(SEGMENT_INDEXES)
+			/**
+			 * @brief Apply the received segments layout
+			 *
+			 * @return true if the layout was valid
+			 */
+			inline bool updateIncomingSegmentsLayout()
+			{
+				uint16_t indexes[MAX_SEGMENTS - 1];
+
+				for (int i = 0; i < segmentsLayout.lanes - 1; i++)
+					indexes[i] = (segmentsLayout.data[2 * i] << 8) | segmentsLayout.data[2 * i + 1];
+
+				return base.setSegmentsLayout(segmentsLayout.lanes, indexes, segmentsLayout.data[2 * (segmentsLayout.lanes - 1)]);
+			}
+
+			/**
+			 * @brief Incoming segments layout: number of lanes, starting indexes (hi, lo) and the reversed lanes mask
+			 *
+			 */
+			struct
+			{
+				uint8_t lanes = 0;
+				uint8_t data[2 * (MAX_SEGMENTS - 1) + 1];
+				uint8_t received = 0;
+
+				inline int size()
+				{
+					return 2 * (lanes - 1) + 1;
+				}
+			} segmentsLayout;
 		#endif
 
 		/**
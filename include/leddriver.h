@@ -0,0 +1,94 @@
+/* leddriver.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+#ifndef LEDDRIVER_H
+#define LEDDRIVER_H
+
+/*
+	LED driver selection and the checks of the build options (CMakeLists.txt),
+	shared by the firmware (source/main.cpp) and the host replay driver (host/replay.cpp).
+*/
+
+#ifdef NEOPIXEL_RGBW
+	#define LED_DRIVER sk6812
+#elif NEOPIXEL_RGB
+	#define LED_DRIVER ws2812
+#endif
+
+#ifdef SPILED_APA102
+	#define LED_DRIVER apa102
+#endif
+#ifdef SPILED_WS2801
+	#define LED_DRIVER ws2801
+#endif
+
+#if defined(SEGMENT_INDEXES)
+	#if defined(SEGMENTS_INDEPENDENT) && defined(NEOPIXEL_RGBW)
+			#undef LED_DRIVER
+			#define LED_DRIVER sk6812i
+	#elif defined(SEGMENTS_INDEPENDENT) && defined(NEOPIXEL_RGB)
+			#undef LED_DRIVER
+			#define LED_DRIVER ws2812i
+	#elif NEOPIXEL_RGBW
+			#undef LED_DRIVER
+			#define LED_DRIVER sk6812p
+	#elif NEOPIXEL_RGB
+			#undef LED_DRIVER
+			#define LED_DRIVER ws2812p
+	#else
+		#error "Parallel mode is unsupportd for selected LEDs configuration"
+	#endif
+#endif
+
+#if defined(STREAMING_RENDER)
+	#if defined(SEGMENT_INDEXES) || !(defined(NEOPIXEL_RGBW) || defined(NEOPIXEL_RGB))
+		#error "Streaming render is supported only for the single lane sk6812/ws2812"
+	#endif
+#endif
+
+#if defined(INTERPOLATION_RENDER) && defined(STREAMING_RENDER)
+	#error "Interpolation render can't be used together with the streaming render"
+#endif
+
+#if defined(DITHERING_RENDER)
+	#if defined(STREAMING_RENDER) || defined(INTERPOLATION_RENDER)
+		#error "Dithering render can't be used together with the streaming or interpolation render"
+	#endif
+	#if !(defined(NEOPIXEL_RGBW) || defined(NEOPIXEL_RGB))
+		#error "Dithering render is supported only for the sk6812/ws2812"
+	#endif
+#endif
+
+#if defined(RENDER_SCHEDULER) && (defined(STREAMING_RENDER) || defined(INTERPOLATION_RENDER) || defined(DITHERING_RENDER))
+	#error "Render scheduler can't be used together with the streaming, interpolation or dithering render"
+#endif
+
+#if defined(FRAME_PACING) && !defined(RENDER_SCHEDULER)
+	#error "Frame pacing requires the render scheduler"
+#endif
+
+#endif
@@ -31,9 +31,10 @@
 	HyperSerialPico led (aka PicoLada) library features:
 	- neopixel (rgb: ws2812b, ws2813..., rgbw: sk6812b) and dotstar (rgb: apa102, hd107, sk9822...) led strip support
 	- single and up to 8 lines parallel (neopixel) mode
+	- up to 8 independent lanes (neopixel): own PIO state machine, DMA channel and buffer for every lane
 	- DMA
 	- PIO neopixel hardware processing
-	- using LUT tables for preparing PIO DMA parallel buffer
+	- using 8x8 bit transposition for preparing PIO DMA parallel buffer
 	- SPI dotstar hardware support
 	- non-blocking rendering (check isReady if it's finished)
 
@@ -47,18 +48,27 @@
 	ledStrip1->SetPixel(index, ColorGrb32(255));
 	ledStrip1->renderSingleLane();
 
-	Usage for sk6812 rgbw multi lanes:
+	Usage for sk6812 rgbw multi lanes (up to 8 lanes on the consecutive outputs):
 	ledStrip1 = new sk6812p(ledsNumber, DATA_PIN); // using DATA_PIN output
 	ledStrip2 = new sk6812p(ledsNumber, DATA_PIN); // using DATA_PIN + 1 output
+	ledStrip3 = new sk6812p(ledsNumber, DATA_PIN); // using DATA_PIN + 2 output
 	ledStrip1->SetPixel(index, ColorGrbw(255));
 	ledStrip2->SetPixel(index, ColorGrbw(255));
-	ledStrip1->renderAllLanes(); // renders ledStrip1 and ledStrip2 simoultaneusly
+	ledStrip3->SetPixel(index, ColorGrbw(255));
+	ledStrip1->renderAllLanes(); // renders all lanes simoultaneusly
 
 	Usage for ws2812 rgb multi lanes:
 	ledStrip1 = new ws2812p(ledsNumber, DATA_PIN); // using DATA_PIN output
 	ledStrip2 = new ws2812p(ledsNumber, DATA_PIN); // using DATA_PIN + 1 output
 	ledStrip1->SetPixel(index, ColorGrb(255));
 	ledStrip2->SetPixel(index, ColorGrb(255));
+	ledStrip1->renderAllLanes(); // renders all lanes simoultaneusly
+
+	Usage for sk6812 rgbw independent lanes (every lane sends only its own length):
+	ledStrip1 = new sk6812i(ledsNumber1, DATA_PIN); // using DATA_PIN output
+	ledStrip2 = new sk6812i(ledsNumber2, DATA_PIN); // using DATA_PIN + 1 output
+	ledStrip1->SetPixel(index, ColorGrbw(255));
+	ledStrip2->SetPixel(index, ColorGrbw(255));
 	ledStrip1->renderAllLanes(); // renders ledStrip1 and ledStrip2 simoultaneusly
 
 	Usage for dotstar rgb single line:
@@ -76,6 +86,10 @@
 #include <pico/binary_info.h>
 #include <algorithm>
 #include <string.h>
+#include "profile.h"
+
+// assumed throughput of the frame copy (word-aligned SRAM to SRAM memcpy): the base of the buffer swap saving estimate
+#define FRAME_COPY_BYTES_PER_CYCLE 2
 
 struct ColorGrb32
 {
@@ -181,6 +195,16 @@ class LedDriver
 	int dmaSize;
 	uint8_t* buffer;
 	uint8_t* dma;
+	uint32_t bufferSwapSaving;
+
+	/**
+	 * @brief Ping-pong: the composed frame goes to the DMA, the previous DMA buffer is used to compose the next frame.
+	 *        Must be called only when the DMA is not busy.
+	 */
+	void swapBuffers()
+	{
+		std::swap(buffer, dma);
+	}
 
 	public:
 
@@ -200,6 +224,10 @@ class LedDriver
 			dmaSize += (4 - (_dmaSize % 4));
 		buffer = reinterpret_cast<uint8_t*>(calloc(dmaSize, 1));
 		dma = reinterpret_cast<uint8_t*>(calloc(dmaSize, 1));
+
+		// estimate the frame copy that is saved by swapping the buffers (no copy is timed while the driver is created)
+		uint32_t bytesPerUs = FRAME_COPY_BYTES_PER_CYCLE * (clock_get_hz(clk_sys) / 1000000);
+		bufferSwapSaving = (dmaSize + bytesPerUs / 2) / bytesPerUs;
 	}
 
 	~LedDriver()
@@ -210,11 +238,30 @@ class LedDriver
 			LedDriverDmaReceiver = nullptr;
 	}
 
+	uint32_t getBufferSwapSaving()
+	{
+		return bufferSwapSaving;
+	}
+
+	/**
+	 * @brief Copy the last sent frame back to the composing buffer (the base for the delta frame).
+	 *        The DMA buffer is only read, so it can be still sending.
+	 */
+	void restoreLastFrame()
+	{
+		memcpy(buffer, dma, dmaSize);
+	}
+
 	static LedDriver* LedDriverDmaReceiver;
 };
 
 LedDriver* LedDriver::LedDriverDmaReceiver = nullptr;
 
+#if defined(STREAMING_RENDER)
+	// result of committing the pixels to the stream
+	enum class StreamCommit { sent, underrun, latched };
+#endif
+
 class DmaClient
 {
 	protected:
@@ -222,16 +269,161 @@ class DmaClient
 	PIO selectedPIO;
 	uint stateIndex;
 
-	static uint PICO_DMA_CHANNEL;
-	static volatile uint64_t lastRenderTime;
-	static volatile bool isDmaBusy;
+	uint dmaChannel;
+	volatile uint64_t lastRenderTime;
+	volatile bool isDmaBusy;
+
+	// receivers of the DMA_IRQ_0 indexed by the DMA channel
+	static DmaClient* dmaClients[NUM_DMA_CHANNELS];
+	static int dmaClientsNumber;
+
+	// the transfer waiting for the end of the latch time: started by the alarm shared by all clients
+	const void* latchSource = nullptr;
+	uint64_t latchDeadline = 0;
+	static int latchAlarm;
+	static volatile uint32_t latchPending;
+	static volatile uint32_t latchDeferred;
+	static volatile uint64_t latchReclaimed;
+
+	// start of the first transfer of the frame that is being sent by all lanes, 0 if idle
+	static volatile uint64_t frameTransferStart;
+
+	public:
+	// called from the DMA IRQ when the transfers of all lanes have finished: start and end time of the frame
+	static void (*frameTransferred)(uint64_t start, uint64_t end);
+
+	#if defined(RENDER_SCHEDULER)
+		// called from the DMA IRQ when the transfers have finished: the render scheduler submits the waiting frame
+		static void (*transferFinished)();
+	#endif
+
+	protected:
+
+	#if defined(STREAMING_RENDER)
+		// streaming render: DMA trails the parser and sends the committed words in chunks
+		const uint32_t* volatile streamSource = nullptr;
+		volatile uint streamSent = 0;
+		volatile uint streamCommitted = 0;
+		volatile uint streamTotal = 0;
+		volatile bool streamStarving = false;
+		// when the DMA ran out of the committed words and the longest gap that the LEDs don't take for the latch
+		volatile uint64_t streamStarveTime = 0;
+		uint64_t streamMaxGap = 0;
+
+		/**
+		 * @brief Send all committed words that were not sent yet. DMA must be idle.
+		 *
+		 */
+		void sendStreamChunk()
+		{
+			uint start = streamSent;
+
+			streamSent = streamCommitted;
+			dma_channel_set_trans_count(dmaChannel, streamCommitted - start, false);
+			dma_channel_set_read_addr(dmaChannel, streamSource + start, true);
+		}
+
+		/**
+		 * @brief Called from the DMA IRQ when the chunk was sent
+		 *
+		 * @return true if the stream is still in progress
+		 */
+		bool continueStream()
+		{
+			if (streamSent < streamCommitted)
+				sendStreamChunk();
+			else if (streamSent < streamTotal)
+			{
+				streamStarving = true;
+				streamStarveTime = time_us_64();
+			}
+			else
+			{
+				streamSource = nullptr;
+				return false;
+			}
+
+			return true;
+		}
+
+		/**
+		 * @brief Start the stream: nothing is sent until the first words are committed. DMA must be idle.
+		 *
+		 * @param source
+		 * @param words
+		 * @param maxGap the reset time of the LEDs: the stream can't resume after the line was idle that long
+		 */
+		void streamBegin(const void* source, uint words, uint64_t maxGap)
+		{
+			isDmaBusy = true;
+
+			// not starving until startAfterLatch: the commits don't start the DMA during the latch time
+			streamSent = 0;
+			streamCommitted = 0;
+			streamTotal = words;
+			streamStarving = false;
+			streamMaxGap = maxGap;
+			streamSource = reinterpret_cast<const uint32_t*>(source);
+		}
+
+		/**
+		 * @brief The starving stream ends here: the line is idle since the DMA sent the last chunk. Interrupts must be disabled.
+		 *
+		 * @param idleSince
+		 */
+		void streamStop(uint64_t idleSince)
+		{
+			streamStarving = false;
+			streamSource = nullptr;
+			lastRenderTime = idleSince;
+			isDmaBusy = false;
+			frameTransferStart = 0;
+		}
+
+		/**
+		 * @brief The words are ready to send: restart the DMA if it has already sent everything before.
+		 *        If the line was idle longer than the reset time, the LEDs have already latched the partial frame
+		 *        and the rest would be shown from the first LED: the stream is stopped instead.
+		 *
+		 * @param words total number of the ready words
+		 * @return StreamCommit::underrun if the DMA was starving, StreamCommit::latched if the stream was stopped
+		 */
+		StreamCommit streamCommit(uint words)
+		{
+			StreamCommit result = StreamCommit::sent;
+			uint32_t irqState = save_and_disable_interrupts();
+
+			streamCommitted = std::min(words, (uint)streamTotal);
+
+			if (streamStarving && streamSent < streamCommitted)
+			{
+				if (streamSent > 0 && time_us_64() - streamStarveTime >= streamMaxGap)
+				{
+					streamStop(streamStarveTime);
+					result = StreamCommit::latched;
+				}
+				else
+				{
+					result = (streamSent > 0) ? StreamCommit::underrun : StreamCommit::sent;
+					streamStarving = false;
+					sendStreamChunk();
+				}
+			}
 
+			restore_interrupts(irqState);
+
+			return result;
+		}
+	#endif
 
 	DmaClient()
 	{
-		PICO_DMA_CHANNEL = dma_claim_unused_channel(true);
+		dmaChannel = dma_claim_unused_channel(true);
 		isDmaBusy = false;
 		lastRenderTime = 0;
+
+		dmaClients[dmaChannel] = this;
+		dmaClientsNumber++;
 	};
 
 	~DmaClient()
@@ -239,11 +431,18 @@ class DmaClient
 		for(int i = 0; i < 10 && isDmaBusy; i++)
 			busy_wait_us(500);
 
-		dma_channel_abort(PICO_DMA_CHANNEL);
-		dma_channel_set_irq0_enabled(PICO_DMA_CHANNEL, false);
-		irq_set_enabled(DMA_IRQ_0, false);
+		uint32_t irqState = save_and_disable_interrupts();
+		latchPending &= ~(1u << dmaChannel);
+		restore_interrupts(irqState);
+
+		dma_channel_abort(dmaChannel);
+		dma_channel_set_irq0_enabled(dmaChannel, false);
+
+		dmaClients[dmaChannel] = nullptr;
+		if (--dmaClientsNumber == 0)
+			irq_set_enabled(DMA_IRQ_0, false);
 
-		dma_channel_unclaim(PICO_DMA_CHANNEL);
+		dma_channel_unclaim(dmaChannel);
 	};
 
 	void dmaConfigure(PIO _selectedPIO, uint _sm)
@@ -254,21 +453,21 @@ class DmaClient
 
 	void initDmaPio(uint dataLenDword32)
 	{
-		dma_channel_config dmaConfig = dma_channel_get_default_config(PICO_DMA_CHANNEL);
+		dma_channel_config dmaConfig = dma_channel_get_default_config(dmaChannel);
 		channel_config_set_dreq(&dmaConfig, pio_get_dreq(selectedPIO, stateIndex, true));
 		channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_32);
 		channel_config_set_read_increment(&dmaConfig, true);
-		dma_channel_configure(PICO_DMA_CHANNEL, &dmaConfig, &selectedPIO->txf[stateIndex], NULL, dataLenDword32, false);
+		dma_channel_configure(dmaChannel, &dmaConfig, &selectedPIO->txf[stateIndex], NULL, dataLenDword32, false);
 
 		assignDmaIrq();
 	};
 
 	void initDmaSpi(spi_inst_t* _spi, uint dataLenByte8)
 	{
-		dma_channel_config dmaConfig = dma_channel_get_default_config(PICO_DMA_CHANNEL);
+		dma_channel_config dmaConfig = dma_channel_get_default_config(dmaChannel);
 		channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_8);
 		channel_config_set_dreq(&dmaConfig, spi_get_dreq(_spi, true));
-		dma_channel_configure(PICO_DMA_CHANNEL, &dmaConfig,&spi_get_hw(_spi)->dr, NULL, dataLenByte8, false);
+		dma_channel_configure(dmaChannel, &dmaConfig,&spi_get_hw(_spi)->dr, NULL, dataLenByte8, false);
 
 		assignDmaIrq();
 	};
@@ -276,14 +475,124 @@ class DmaClient
 	void assignDmaIrq()
 	{
 		irq_set_exclusive_handler(DMA_IRQ_0, dmaFinishReceiver);
-		dma_channel_set_irq0_enabled(PICO_DMA_CHANNEL, true);
+		dma_channel_set_irq0_enabled(dmaChannel, true);
 		irq_set_enabled(DMA_IRQ_0, true);
+
+		// the alarm IRQ is handled by the same core as the DMA IRQ
+		if (latchAlarm < 0)
+		{
+			latchAlarm = hardware_alarm_claim_unused(true);
+			hardware_alarm_set_callback(latchAlarm, onLatchAlarm);
+		}
 	};
 
+	/**
+	 * @brief Start the prepared transfer (the latch time has passed)
+	 *
+	 */
+	void startTransfer()
+	{
+		if (frameTransferStart == 0)
+			frameTransferStart = time_us_64();
+
+		#if defined(STREAMING_RENDER)
+			if (streamSource != nullptr)
+			{
+				// aborted before anything was sent: nothing to latch
+				if (!continueStream())
+				{
+					isDmaBusy = false;
+					frameTransferStart = 0;
+				}
+				return;
+			}
+		#endif
+
+		dma_channel_set_read_addr(dmaChannel, latchSource, true);
+	}
+
+	/**
+	 * @brief Start the transfer at the end of the latch time of the previous frame without waiting for it:
+	 *        if it hasn't passed yet, the latch alarm starts the transfer. isDmaBusy must be already set.
+	 *
+	 * @param source the data to send, ignored for the stream
+	 * @param latchEnd
+	 */
+	void startAfterLatch(const void* source, uint64_t latchEnd)
+	{
+		uint32_t irqState = save_and_disable_interrupts();
+		uint64_t currentTime = time_us_64();
+
+		latchSource = source;
+
+		if (currentTime >= latchEnd)
+			startTransfer();
+		else
+		{
+			latchDeadline = latchEnd;
+			latchPending |= 1u << dmaChannel;
+			latchDeferred++;
+			latchReclaimed += latchEnd - currentTime;
+			armLatchAlarm();
+		}
+
+		restore_interrupts(irqState);
+	}
+
+	/**
+	 * @brief Start the transfers whose latch time has passed
+	 *
+	 */
+	static void startLatchedClients()
+	{
+		uint64_t currentTime = time_us_64();
+
+		for (uint32_t pending = latchPending; pending != 0; pending &= pending - 1)
+		{
+			uint channel = __builtin_ctz(pending);
+			DmaClient* client = dmaClients[channel];
+
+			if (client != nullptr && client->latchDeadline <= currentTime)
+			{
+				latchPending &= ~(1u << channel);
+				client->startTransfer();
+			}
+		}
+	}
+
+	/**
+	 * @brief Set the latch alarm to the nearest deadline of the waiting transfers
+	 *
+	 */
+	static void armLatchAlarm()
+	{
+		while (latchPending != 0)
+		{
+			uint64_t deadline = UINT64_MAX;
+
+			for (uint32_t pending = latchPending; pending != 0; pending &= pending - 1)
+				deadline = std::min(deadline, dmaClients[__builtin_ctz(pending)]->latchDeadline);
+
+			if (!hardware_alarm_set_target(latchAlarm, from_us_since_boot(deadline)))
+				return;
+
+			// the deadline has already passed
+			startLatchedClients();
+		}
+	}
+
+	static void onLatchAlarm(uint)
+	{
+		startLatchedClients();
+		armLatchAlarm();
+	}
+
 	public:
 
 	bool isReadyBlocking()
 	{
+		PROFILE_SCOPE_IF(stripWait, isDmaBusy);
+
 		int wait = 200;
 		while(isDmaBusy && wait-- > 0)
 			busy_wait_us(50);
@@ -296,15 +605,82 @@ class DmaClient
 		return !isDmaBusy;
 	}
 
+	/**
+	 * @brief The transfers started by the latch alarm and the total latch time the renderer didn't have to wait
+	 *
+	 * @param deferred
+	 * @param reclaimed [us]
+	 */
+	static void getLatchStatistics(uint32_t& deferred, uint64_t& reclaimed)
+	{
+		uint32_t irqState = save_and_disable_interrupts();
+		deferred = latchDeferred;
+		reclaimed = latchReclaimed;
+		restore_interrupts(irqState);
+	}
+
+	static void resetLatchStatistics()
+	{
+		uint32_t irqState = save_and_disable_interrupts();
+		latchDeferred = 0;
+		latchReclaimed = 0;
+		restore_interrupts(irqState);
+	}
+
+	#if defined(STREAMING_RENDER)
+		/**
+		 * @brief Stop the stream: the chunk that is being sent is completed, nothing more
+		 *
+		 */
+		void streamAbort()
+		{
+			uint32_t irqState = save_and_disable_interrupts();
+
+			streamTotal = streamCommitted = streamSent;
+
+			if (streamStarving)
+				streamStop(time_us_64());
+
+			restore_interrupts(irqState);
+		}
+	#endif
+
 	static void dmaFinishReceiver()
 	{
-		if (dma_hw->ints0 & (1u<<DmaClient::PICO_DMA_CHANNEL))
+		uint32_t finished = dma_hw->ints0;
+		uint64_t currentTime = time_us_64();
+
+		dma_hw->ints0 = finished;
+
+		for (; finished != 0; finished &= finished - 1)
 		{
-			dma_hw->ints0 = (1u<<DmaClient::PICO_DMA_CHANNEL);
+			DmaClient* client = dmaClients[__builtin_ctz(finished)];
 
-			lastRenderTime = time_us_64();
-			isDmaBusy = false;
+			if (client != nullptr)
+			{
+				#if defined(STREAMING_RENDER)
+					if (client->streamSource != nullptr && client->continueStream())
+						continue;
+				#endif
+
+				client->lastRenderTime = currentTime;
+				client->isDmaBusy = false;
+			}
+		}
+
+		if (frameTransferStart != 0 && std::none_of(std::begin(dmaClients), std::end(dmaClients),
+				[](DmaClient* client) { return client != nullptr && client->isDmaBusy; }))
+		{
+			if (frameTransferred != nullptr)
+				frameTransferred(frameTransferStart, currentTime);
+
+			frameTransferStart = 0;
 		}
+
+		#if defined(RENDER_SCHEDULER)
+			if (transferFinished != nullptr)
+				transferFinished();
+		#endif
 	}
 };
 
@@ -314,24 +690,96 @@ class Neopixel : public LedDriver, public DmaClient
 {
 
 	uint64_t resetTime;
+	const pio_program_t* program;
+	uint programAddress;
+
+	// the programs in the instruction memory of pio0 and pio1: loaded once and shared by the outputs
+	struct LoadedProgram
+	{
+		const pio_program_t* program;
+		uint address;
+		int users;
+	};
+
+	static LoadedProgram loadedPrograms[2][2];
 
 	friend class NeopixelParallel;
 
+	static LoadedProgram* findProgram(PIO pio, const pio_program_t* program)
+	{
+		for (auto& loaded : loadedPrograms[pio_get_index(pio)])
+			if (loaded.users > 0 && loaded.program == program)
+				return &loaded;
+
+		return nullptr;
+	}
+
+	static bool canUseProgram(PIO pio, const pio_program_t* program)
+	{
+		if (findProgram(pio, program) != nullptr)
+			return true;
+
+		return pio_can_add_program(pio, program) &&
+			std::any_of(std::begin(loadedPrograms[pio_get_index(pio)]), std::end(loadedPrograms[pio_get_index(pio)]),
+				[](const LoadedProgram& loaded) { return loaded.users == 0; });
+	}
+
+	static uint acquireProgram(PIO pio, const pio_program_t* program)
+	{
+		LoadedProgram* loaded = findProgram(pio, program);
+
+		if (loaded == nullptr)
+		{
+			auto& programs = loadedPrograms[pio_get_index(pio)];
+
+			loaded = std::find_if(std::begin(programs), std::end(programs), [](const LoadedProgram& slot) { return slot.users == 0; });
+			loaded->program = program;
+			loaded->address = pio_add_program(pio, program);
+		}
+
+		loaded->users++;
+		return loaded->address;
+	}
+
+	static void releaseProgram(PIO pio, const pio_program_t* program)
+	{
+		LoadedProgram* loaded = findProgram(pio, program);
+
+		if (loaded != nullptr && --loaded->users == 0)
+			pio_remove_program(pio, program, loaded->address);
+	}
+
 	public:
 	Neopixel(NeopixelSubtype timingType, int lanes, uint64_t _resetTime, int _ledsNumber, int _pin, int _dmaSize, bool alignTo24 = false):
 			LedDriver(_ledsNumber, _pin, _dmaSize)
 	{
 		pio_sm_config smConfig;
-		uint programAddress;
 
-		dmaConfigure(pio0, 0);
+		if (lanes >= 1)
+			program = (timingType == NeopixelSubtype::ws2812b) ? &neopixel_ws2812b_parallel_program : &neopixel_parallel_program;
+		else
+			program = (timingType == NeopixelSubtype::ws2812b) ? &neopixel_ws2812b_program : &neopixel_program;
+
+		// every output can have own state machine: use pio1 when pio0 has no free state machine or instruction memory
+		int sm = -1;
+		PIO pio = nullptr;
+
+		for (PIO candidate : { pio0, pio1 })
+			if (sm < 0 && canUseProgram(candidate, program))
+			{
+				pio = candidate;
+				sm = pio_claim_unused_sm(candidate, false);
+			}
+
+		if (sm < 0)
+			panic("No PIO state machine or instruction memory left for the LED output");
+
+		dmaConfigure(pio, sm);
+		programAddress = acquireProgram(selectedPIO, program);
 		resetTime = _resetTime;
 
 		if (lanes >= 1)
 		{
-			programAddress = (timingType == NeopixelSubtype::ws2812b) ?
-				pio_add_program(selectedPIO,  &neopixel_ws2812b_parallel_program) : pio_add_program(selectedPIO,  &neopixel_parallel_program);
-
 			for(uint i=_pin; i<_pin + lanes; i++){
 				pio_gpio_init(selectedPIO, i);
 			}
@@ -344,9 +792,6 @@ class Neopixel : public LedDriver, public DmaClient
 		}
 		else
 		{
-			programAddress = (timingType == NeopixelSubtype::ws2812b) ?
-				pio_add_program(selectedPIO,  &neopixel_ws2812b_program) : pio_add_program(selectedPIO,  &neopixel_program);
-
 			pio_gpio_init(selectedPIO, _pin);
 
 			smConfig = (timingType == NeopixelSubtype::ws2812b) ?
@@ -366,31 +811,92 @@ class Neopixel : public LedDriver, public DmaClient
 		initDmaPio(dmaSize / 4);
 	}
 
+	~Neopixel()
+	{
+		isReadyBlocking();
+
+		pio_sm_set_enabled(selectedPIO, stateIndex, false);
+		releaseProgram(selectedPIO, program);
+		pio_sm_unclaim(selectedPIO, stateIndex);
+	}
+
 	uint8_t* getBufferMemory()
 	{
 		return buffer;
 	}
 
+	/**
+	 * @brief The end of the reset (latch) time of the last frame: the next frame can't start earlier
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t getLatchEnd()
+	{
+		return lastRenderTime + resetTime;
+	}
+
 	protected:
 
-	void renderDma(bool resetBuffer)
+	/**
+	 * @brief Start the DMA transfer
+	 *
+	 * @param swap true: send the composed buffer (ping-pong), false: the DMA buffer was already prepared by the caller
+	 */
+	void renderDma(bool swap)
 	{
 		if (isDmaBusy)
 			return;
 
 		isDmaBusy = true;
 
-		uint64_t currentTime = time_us_64();
-		if (currentTime < resetTime + lastRenderTime)
-			busy_wait_us(std::min(resetTime + lastRenderTime - currentTime, resetTime));
+		if (swap)
+			swapBuffers();
 
-		memcpy(dma, buffer, dmaSize);
+		#if defined(STREAMING_RENDER)
+			// the stream could change it
+			dma_channel_set_trans_count(dmaChannel, dmaSize / 4, false);
+		#endif
 
-		dma_channel_set_read_addr(PICO_DMA_CHANNEL, dma, true);
-
-		if (resetBuffer)
-			memset(buffer, 0, dmaSize);
+		startAfterLatch(dma, getLatchEnd());
 	}
+
+	public:
+
+	#if defined(STREAMING_RENDER)
+		/**
+		 * @brief Start sending the composed buffer while it's still being filled
+		 *
+		 */
+		void streamBegin()
+		{
+			DmaClient::streamBegin(buffer, dmaSize / 4, resetTime);
+			startAfterLatch(buffer, getLatchEnd());
+		}
+
+		/**
+		 * @brief The streamed frame was received correctly: it's the last good frame now
+		 *
+		 * @return false if the LEDs have latched the partial frame: the stream was stopped, the whole frame must be rendered
+		 */
+		bool streamFinish()
+		{
+			if (DmaClient::streamCommit(dmaSize / 4) == StreamCommit::latched)
+				return false;
+
+			swapBuffers();
+			return true;
+		}
+
+		/**
+		 * @brief The reset (latch) time of the LEDs: the data line that is idle that long shows the received data
+		 *
+		 * @return uint64_t
+		 */
+		uint64_t getResetTime()
+		{
+			return resetTime;
+		}
+	#endif
 };
 
 template<NeopixelSubtype _type, int RESET_TIME, typename colorData>
@@ -405,33 +911,171 @@ class NeopixelType : public Neopixel
 
 	void SetPixel(int index, colorData color)
 	{
+		PROFILE_SCOPE(setPixel);
+
 		if (index >= ledsNumber)
 			return;
 
 		*(reinterpret_cast<colorData*>(buffer)+index) = color;
 	}
 
-	void renderSingleLane()
+	/**
+	 * @brief Render the composed frame
+	 *
+	 * @param newFrame false: send again the last frame
+	 */
+	void renderSingleLane(bool newFrame = true)
 	{
-		renderDma(false);
+		renderDma(newFrame);
 	}
+
+	#if defined(STREAMING_RENDER)
+		/**
+		 * @brief Commit the pixels that are ready for the stream
+		 *
+		 * @param leds
+		 * @return StreamCommit::underrun if the stream was starving, StreamCommit::latched if it was stopped
+		 */
+		StreamCommit streamCommit(int leds)
+		{
+			return DmaClient::streamCommit(leds * sizeof(colorData) / 4);
+		}
+	#endif
 };
 
+/**
+ * @brief Transpose 8x8 bit matrix. Byte 'n' of the input words is the color byte of the lane 'n'.
+ *        Every byte of the output words contains the same bit of all lanes (lane 'n' at bit 'n')
+ *        in the order expected by the parallel PIO program: bits 7..4 in the first word, 3..0 in the second.
+ *
+ * @param lanes0_3
+ * @param lanes4_7
+ * @param target
+ */
+static inline void transposeLanes(uint32_t lanes0_3, uint32_t lanes4_7, uint32_t* target)
+{
+	uint32_t x = lanes4_7, y = lanes0_3, t;
+
+	t = (x ^ (x >> 7)) & 0x00AA00AA;
+	x = x ^ t ^ (t << 7);
+	t = (y ^ (y >> 7)) & 0x00AA00AA;
+	y = y ^ t ^ (t << 7);
+
+	t = (x ^ (x >> 14)) & 0x0000CCCC;
+	x = x ^ t ^ (t << 14);
+	t = (y ^ (y >> 14)) & 0x0000CCCC;
+	y = y ^ t ^ (t << 14);
+
+	t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+	y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+
+	target[0] = t;
+	target[1] = y;
+}
+
+template<NeopixelSubtype _type, int RESET_TIME, typename colorData>
+class NeopixelIndependentType : public NeopixelType<_type, RESET_TIME, colorData>
+{
+	static NeopixelIndependentType* lanes[8];
+	static int instances;
+
+	const uint8_t myLane;
+
+	public:
+
+	NeopixelIndependentType(int _ledsNumber, int _basePinForLanes) :
+		NeopixelType<_type, RESET_TIME, colorData>(_ledsNumber, _basePinForLanes + instances),
+		myLane(instances++)
+	{
+		lanes[myLane] = this;
+	}
+
+	~NeopixelIndependentType()
+	{
+		lanes[myLane] = nullptr;
+
+		if (instances > 0)
+			instances--;
+	}
+
+	bool isReadyBlocking()
+	{
+		for (int i = 0; i < instances; i++)
+			if (!lanes[i]->NeopixelType<_type, RESET_TIME, colorData>::isReadyBlocking())
+				return false;
+
+		return true;
+	}
+
+	bool isReady()
+	{
+		for (int i = 0; i < instances; i++)
+			if (!lanes[i]->NeopixelType<_type, RESET_TIME, colorData>::isReady())
+				return false;
+
+		return true;
+	}
+
+	uint64_t getLatchEnd()
+	{
+		uint64_t latchEnd = 0;
+
+		for (int i = 0; i < instances; i++)
+			latchEnd = std::max(latchEnd, lanes[i]->Neopixel::getLatchEnd());
+
+		return latchEnd;
+	}
+
+	uint32_t getBufferSwapSaving()
+	{
+		uint32_t saving = 0;
+
+		for (int i = 0; i < instances; i++)
+			saving += lanes[i]->LedDriver::getBufferSwapSaving();
+
+		return saving;
+	}
+
+	void restoreLastFrame()
+	{
+		for (int i = 0; i < instances; i++)
+			lanes[i]->LedDriver::restoreLastFrame();
+	}
+
+	/**
+	 * @brief Start all lanes: every lane sends only its own length, the frame is done when all DMA channels complete
+	 *
+	 */
+	void renderAllLanes()
+	{
+		if (!isReady())
+			return;
+
+		for (int i = 0; i < instances; i++)
+			lanes[i]->renderDma(true);
+	}
+};
+
+template<NeopixelSubtype _type, int RESET_TIME, typename colorData>
+NeopixelIndependentType<_type, RESET_TIME, colorData>* NeopixelIndependentType<_type, RESET_TIME, colorData>::lanes[8] = {};
+template<NeopixelSubtype _type, int RESET_TIME, typename colorData>
+int NeopixelIndependentType<_type, RESET_TIME, colorData>::instances = 0;
 
 class NeopixelParallel
 {
-	static Neopixel *muxer;
 	static int instances;
+	static Neopixel *muxer;
 
 	protected:
 	static int maxLeds;
-	const uint8_t myLaneMask;
+	const uint8_t myLane;
+	// lane bytes of every pixel: [index][color byte][lane], transposed to the DMA buffer when rendering
 	static uint8_t* buffer;
 
 	public:
 
 	NeopixelParallel(NeopixelSubtype _type, size_t pixelSize, uint64_t _resetTime, int _ledsNumber, int _pin):
-					myLaneMask(1 << (instances++))
+					myLane(instances++)
 	{
 		maxLeds = std::max(maxLeds, _ledsNumber);
 
@@ -464,43 +1108,110 @@ class NeopixelParallel
 		return muxer->isReady();
 	}
 
-	void renderAllLanes()
+	uint64_t getLatchEnd()
 	{
-		muxer->renderDma(true);
+		return muxer->getLatchEnd();
+	}
+
+	uint32_t getBufferSwapSaving()
+	{
+		return muxer->getBufferSwapSaving();
+	}
+
+	protected:
+
+	static uint8_t* getDmaMemory()
+	{
+		return muxer->dma;
+	}
+
+	static void renderDma()
+	{
+		muxer->renderDma(false);
 	}
 };
 
 template<NeopixelSubtype _type, int RESET_TIME, typename colorData>
 class NeopixelParallelType : public NeopixelParallel
 {
-	uint32_t lut[16];
-
 	public:
 
 	NeopixelParallelType(int _ledsNumber, int _basePinForLanes) :
 		NeopixelParallel(_type, sizeof(colorData), RESET_TIME, _ledsNumber, _basePinForLanes)
 	{
-		for (uint8_t a = 0; a < 16; a++)
-		{
-			uint8_t* target = reinterpret_cast<uint8_t*>(&(lut[a]));
-			for (uint8_t b = 0; b < 4; b++)
-				*(target++) = (uint8_t) ((a & (0b00000001 << b)) ? myLaneMask : 0);
-		}
 	}
 
 	void SetPixel(int index, colorData color)
 	{
+		PROFILE_SCOPE(setPixel);
+
 		if (index >= maxLeds)
 			return;
 
 		uint8_t* source = reinterpret_cast<uint8_t*>(&color);
-		uint32_t* target = reinterpret_cast<uint32_t*>(&(buffer[(index + 1) * 8 * sizeof(colorData)]));
+		uint8_t* target = &(buffer[index * 8 * sizeof(colorData) + myLane]);
 
-		for(int i = 0; i < sizeof(colorData); i++)
-		{
-			*(--target) |= lut[ *(source) & 0b00001111];
-			*(--target) |= lut[ *(source++) >> 4];
-		}
+		for(int i = 0; i < sizeof(colorData); i++, target += 8)
+			*target = *(source++);
+	}
+
+	/**
+	 * @brief Encode the lane bytes to the PIO bitplanes. The color bytes are sent in the reversed memory order
+	 *        of colorData (G first). Each output word is written once, so the buffer doesn't need clearing.
+	 *
+	 * @param source
+	 * @param target
+	 */
+	static void encodeLanes(const uint8_t* source, uint8_t* target)
+	{
+		const uint32_t* input = reinterpret_cast<const uint32_t*>(source);
+		uint32_t* output = reinterpret_cast<uint32_t*>(target);
+		const int words = 2 * sizeof(colorData);
+
+		for (int i = 0; i < maxLeds; i++, input += words, output += words)
+			for (int k = 0; k < sizeof(colorData); k++)
+				transposeLanes(input[2 * k], input[2 * k + 1], &(output[words - 2 - 2 * k]));
+	}
+
+	/**
+	 * @brief Decode the PIO bitplanes back to the lane bytes. The transposition is its own inverse
+	 *        when the words are swapped on the input and on the output.
+	 *
+	 * @param source
+	 * @param target
+	 */
+	static void decodeLanes(const uint8_t* source, uint8_t* target)
+	{
+		const uint32_t* input = reinterpret_cast<const uint32_t*>(source);
+		uint32_t* output = reinterpret_cast<uint32_t*>(target);
+		const int words = 2 * sizeof(colorData);
+		uint32_t lanes[2];
+
+		for (int i = 0; i < maxLeds; i++, input += words, output += words)
+			for (int k = 0; k < sizeof(colorData); k++)
+			{
+				transposeLanes(input[words - 1 - 2 * k], input[words - 2 - 2 * k], lanes);
+				output[2 * k] = lanes[1];
+				output[2 * k + 1] = lanes[0];
+			}
+	}
+
+	/**
+	 * @brief Rebuild the lane bytes of all lanes from the last sent frame (the base for the delta frame)
+	 *
+	 */
+	void restoreLastFrame()
+	{
+		decodeLanes(getDmaMemory(), buffer);
+	}
+
+	void renderAllLanes()
+	{
+		if (!isReady())
+			return;
+
+		encodeLanes(buffer, getDmaMemory());
+		renderDma();
 	}
 };
 
@@ -530,6 +1241,16 @@ class Dotstar : public LedDriver, public DmaClient
 		return buffer;
 	}
 
+	/**
+	 * @brief The end of the reset (latch) time of the last frame: the next frame can't start earlier
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t getLatchEnd()
+	{
+		return lastRenderTime + resetTime;
+	}
+
 	protected:
 
 	void renderDma()
@@ -539,13 +1260,9 @@ class Dotstar : public LedDriver, public DmaClient
 
 		isDmaBusy = true;
 
-		uint64_t currentTime = time_us_64();
-		if (currentTime < resetTime + lastRenderTime)
-			busy_wait_us(std::min(resetTime + lastRenderTime - currentTime, resetTime));
+		swapBuffers();
 
-		memcpy(dma, buffer, dmaSize);
-
-		dma_channel_set_read_addr(PICO_DMA_CHANNEL, dma, true);
+		startAfterLatch(dma, getLatchEnd());
 	}
 };
 
@@ -561,6 +1278,8 @@ class DotstarType : public Dotstar
 
 	void SetPixel(int index, colorData color)
 	{
+		PROFILE_SCOPE(setPixel);
+
 		if (index >= ledsNumber)
 			return;
 
@@ -599,6 +1318,16 @@ class Ws2801 : public LedDriver, public DmaClient
 		return buffer;
 	}
 
+	/**
+	 * @brief The end of the reset (latch) time of the last frame: the next frame can't start earlier
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t getLatchEnd()
+	{
+		return lastRenderTime + resetTime;
+	}
+
 	protected:
 
 	void renderDma()
@@ -608,13 +1337,9 @@ class Ws2801 : public LedDriver, public DmaClient
 
 		isDmaBusy = true;
 
-		uint64_t currentTime = time_us_64();
-		if (currentTime < resetTime + lastRenderTime)
-			busy_wait_us(std::min(resetTime + lastRenderTime - currentTime, resetTime));
-
-		memcpy(dma, buffer, dmaSize);
+		swapBuffers();
 
-		dma_channel_set_read_addr(PICO_DMA_CHANNEL, dma, true);
+		startAfterLatch(dma, getLatchEnd());
 	}
 };
 
@@ -630,6 +1355,8 @@ class Ws2801Type : public Ws2801
 
 	void SetPixel(int index, colorData color)
 	{
+		PROFILE_SCOPE(setPixel);
+
 		if (index >= ledsNumber)
 			return;
 
@@ -646,9 +1373,18 @@ Neopixel* NeopixelParallel::muxer = nullptr;
 uint8_t* NeopixelParallel::buffer = nullptr;
 int NeopixelParallel::instances = 0;
 int NeopixelParallel::maxLeds = 0;
-uint DmaClient::PICO_DMA_CHANNEL = 0;
-volatile uint64_t DmaClient::lastRenderTime = 0;
-volatile bool DmaClient::isDmaBusy = false;
+DmaClient* DmaClient::dmaClients[NUM_DMA_CHANNELS] = {};
+int DmaClient::dmaClientsNumber = 0;
+int DmaClient::latchAlarm = -1;
+volatile uint32_t DmaClient::latchPending = 0;
+volatile uint32_t DmaClient::latchDeferred = 0;
+volatile uint64_t DmaClient::latchReclaimed = 0;
+volatile uint64_t DmaClient::frameTransferStart = 0;
+void (*DmaClient::frameTransferred)(uint64_t start, uint64_t end) = nullptr;
+Neopixel::LoadedProgram Neopixel::loadedPrograms[2][2] = {};
+#if defined(RENDER_SCHEDULER)
+	void (*DmaClient::transferFinished)() = nullptr;
+#endif
 
 
 // API classes
@@ -656,5 +1392,7 @@ typedef NeopixelType<NeopixelSubtype::ws2812b, 650, ColorGrb32> ws2812;
 typedef NeopixelType<NeopixelSubtype::sk6812, 450, ColorGrbw> sk6812;
 typedef NeopixelParallelType<NeopixelSubtype::ws2812b, 300, ColorGrb> ws2812p;
 typedef NeopixelParallelType<NeopixelSubtype::sk6812, 80, ColorGrbw> sk6812p;
+typedef NeopixelIndependentType<NeopixelSubtype::ws2812b, 650, ColorGrb32> ws2812i;
+typedef NeopixelIndependentType<NeopixelSubtype::sk6812, 450, ColorGrbw> sk6812i;
 typedef DotstarType<100, ColorDotstartBgr> apa102;
 typedef Ws2801Type<500, ColorRgb> ws2801;
@@ -0,0 +1,207 @@
+/* logger.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <stdarg.h>
+#include <stdio.h>
+#include "ringbuffer.h"
+
+// deferred output: the messages and the telemetry records (the text report is formatted by core0 and doesn't take the space)
+#define LOG_BUFFER_SIZE 2048
+// the longest line of the text report
+#define LOG_REPORT_LINE_SIZE 256
+// core0 checks the deferred output at least that often when no data comes [us]
+#define LOG_DRAIN_PERIOD 2000
+
+// formats the line of the text report on core0: the length, 0 to skip the line, -1 after the last line
+typedef int (*ReportFormatter)(int line, char* output, int size);
+
+/**
+ * @brief Deferred output of core1: the text and the telemetry records are queued without waiting for the USB
+ *        and core0 sends them when it's idle. The message that doesn't fit is dropped as a whole and counted.
+ *        The text report is only marked in the output: core0 formats it line by line when it gets there.
+ *
+ */
+class
+{
+	RingBuffer<LOG_BUFFER_SIZE> ring;
+
+	// the pending text report (set by core1, cleared by core0 after its last line) and its position in the output
+	std::atomic<ReportFormatter> reportFormatter{nullptr};
+	uint32_t reportPosition = 0;
+	uint32_t droppedReports = 0;
+
+	// core0: the line of the report that is being sent
+	char reportOutput[LOG_REPORT_LINE_SIZE];
+	int reportLine = 0;
+	int reportLength = 0;
+	int reportSent = 0;
+	bool reportSpan = false;
+
+	public:
+		/**
+		 * @brief core1: queue the message
+		 *
+		 * @param data
+		 * @param length
+		 * @return false if it was dropped
+		 */
+		bool write(const void* data, uint32_t length)
+		{
+			if (length > ring.getFreeSpace())
+			{
+				ring.addDropped(length);
+				return false;
+			}
+
+			ring.write(reinterpret_cast<const uint8_t*>(data), length);
+			return true;
+		}
+
+		inline bool write(const char* text)
+		{
+			return write(text, strlen(text));
+		}
+
+		bool printf(const char* format, ...) __attribute__((format(printf, 2, 3)))
+		{
+			char output[128];
+			va_list args;
+
+			va_start(args, format);
+			int length = vsnprintf(output, sizeof(output), format, args);
+			va_end(args);
+
+			return length > 0 && write(output, std::min(length, (int)sizeof(output) - 1));
+		}
+
+		/**
+		 * @brief core1: the values of the new text report can be saved (the previous one was sent)
+		 *
+		 * @return false if the report is still pending: the new one is dropped and counted
+		 */
+		bool reserveReport()
+		{
+			if (reportFormatter.load(std::memory_order_acquire) == nullptr)
+				return true;
+
+			droppedReports++;
+			return false;
+		}
+
+		/**
+		 * @brief core1: queue the text report after the current output, its values must be saved already (reserveReport)
+		 *
+		 * @param formatter called by core0 for every line
+		 */
+		void writeReport(ReportFormatter formatter)
+		{
+			reportPosition = ring.getWritePosition();
+			reportFormatter.store(formatter, std::memory_order_release);
+		}
+
+		/**
+		 * @brief core1: bytes of the dropped messages
+		 *
+		 * @return uint32_t
+		 */
+		inline uint32_t getDropped()
+		{
+			return ring.getDropped();
+		}
+
+		/**
+		 * @brief core1: the text reports dropped because the previous one was still pending
+		 *
+		 * @return uint32_t
+		 */
+		inline uint32_t getDroppedReports()
+		{
+			return droppedReports;
+		}
+
+		/**
+		 * @brief core0: the contiguous queued output, the lines of the report are formatted when the output before it was sent
+		 *
+		 * @param length [out]
+		 * @return const uint8_t*
+		 */
+		const uint8_t* getPending(uint32_t& length)
+		{
+			const uint8_t* data = ring.getReadSpan(length);
+			ReportFormatter formatter = reportFormatter.load(std::memory_order_acquire);
+
+			reportSpan = false;
+
+			if (formatter == nullptr)
+				return data;
+
+			uint32_t before = ring.getReadDistance(reportPosition);
+			if (before > 0)
+			{
+				length = std::min(length, before);
+				return data;
+			}
+
+			while (reportSent == reportLength)
+			{
+				reportLength = formatter(reportLine++, reportOutput, sizeof(reportOutput));
+				reportSent = 0;
+
+				if (reportLength < 0)
+				{
+					reportLine = 0;
+					reportLength = 0;
+					reportFormatter.store(nullptr, std::memory_order_release);
+					return ring.getReadSpan(length);
+				}
+			}
+
+			reportSpan = true;
+			length = reportLength - reportSent;
+			return reinterpret_cast<const uint8_t*>(reportOutput) + reportSent;
+		}
+
+		/**
+		 * @brief core0: the output was sent
+		 *
+		 * @param length
+		 */
+		inline void consume(uint32_t length)
+		{
+			if (reportSpan)
+				reportSent += length;
+			else
+				ring.consume(length);
+		}
+} logger;
+
+#endif
@@ -28,11 +28,32 @@
 #ifndef MAIN_H
 #define MAIN_H
 
-#define MAX_BUFFER (3013 * 3 + 1)
+// the ring buffer holds at least two complete frames of MAX_LEDS pixels: the header, 4 bytes per pixel
+// (6 for the high precision frames) and the checksums, plus the byte that is always kept free
+#ifndef MAX_LEDS
+	#define MAX_LEDS 3013
+#endif
+#if defined(DITHERING_RENDER)
+	#define MAX_PIXEL_SIZE 6
+#else
+	#define MAX_PIXEL_SIZE 4
+#endif
+#define MAX_BUFFER (2 * (6 + MAX_LEDS * MAX_PIXEL_SIZE + 3) + 1)
 #define HELLO_MESSAGE "\r\nWelcome!\r\nAwa driver 11.\r\n"
+// control frame (count 0x2aa2) commands
+#define COMMAND_STATISTICS 0x15
+#define COMMAND_STATISTICS_SILENT 0x35
+#define COMMAND_STATISTICS_BINARY 0x55
+#define COMMAND_SEGMENTS_LAYOUT 0x45
+#define COMMAND_COLOR_LUT 0x65
+#define COMMAND_PROFILE 0x75
 
+#include "logger.h"
+#include "telemetry.h"
 #include "calibration.h"
+#include "colorlut.h"
 #include "statistics.h"
+#include "ringbuffer.h"
 #include "base.h"
 #include "framestate.h"
 
@@ -44,6 +65,447 @@ void updateMainStatistics(unsigned long currentTime, unsigned long deltaTime, bo
 		statistics.lightReset(currentTime, hasData);
 }
 
+/**
+ * @brief All pixels of the current run were received: continue with the next delta frame range or the frame trailer
+ *
+ */
+inline void finishPixelRun()
+{
+	if (frameState.isCompressedFrame())
+		frameState.setState((frameState.getFrameRemainingLeds() > 0) ? AwaProtocol::COMPRESSED_TOKEN : AwaProtocol::FLETCHER1);
+	else if (frameState.isDeltaFrame())
+		frameState.setState(AwaProtocol::DELTA_OFFSET_HI);
+	else if (frameState.isProtocolVersion2())
+		frameState.setState(AwaProtocol::VERSION2_GAIN);
+	else
+		frameState.setState(AwaProtocol::FLETCHER1);
+}
+
+/**
+ * @brief Decode one pixel of the frame to frameState.color
+ *
+ * @tparam extraByte protocol version 3: every pixel has the 4th byte (white channel or brightness)
+ * @tparam correction apply the uploaded color LUT to the red, green and blue channels
+ * @param input
+ */
+template<bool extraByte, bool correction>
+inline void decodeColor(const volatile uint8_t* input)
+{
+	ColorDefinition& color = frameState.color;
+
+	color.R = colorLut.correct<correction>(0, input[0]);
+	color.G = colorLut.correct<correction>(1, input[1]);
+	color.B = colorLut.correct<correction>(2, input[2]);
+
+	if (extraByte)
+	{
+		#ifdef NEOPIXEL_RGBW
+			color.W = input[3];
+		#elif defined(SPILED_APA102)
+			color.Brightness = input[3];
+		#endif
+	}
+	else
+	{
+		#if defined(SPILED_APA102)
+			color.Brightness = 0xFF;
+		#endif
+
+		#ifdef NEOPIXEL_RGBW
+			// calculate RGBW from RGB using provided calibration data
+			frameState.rgb2rgbw();
+		#endif
+	}
+}
+
+/**
+ * @brief Decode one pixel of the current protocol version to frameState.color
+ *
+ * @param input
+ */
+inline void decodeColor(const volatile uint8_t* input)
+{
+	if (colorLut.isEnabled())
+	{
+		if (frameState.isProtocolVersion3())
+			decodeColor<true, true>(input);
+		else
+			decodeColor<false, true>(input);
+	}
+	else if (frameState.isProtocolVersion3())
+		decodeColor<true, false>(input);
+	else
+		decodeColor<false, false>(input);
+}
+
+/**
+ * @brief Decode a contiguous run of complete pixels directly from the ring buffer
+ *
+ * @tparam extraByte protocol version 3: every pixel has the 4th byte (white channel or brightness)
+ * @tparam correction apply the uploaded color LUT
+ * @param input
+ * @param pixels
+ */
+template<bool extraByte, bool correction>
+inline void decodePixelSpan(const volatile uint8_t* input, int pixels)
+{
+	base.setStripPixels(frameState.advanceLedIndex(pixels), pixels, [&](auto* strip, int index, int step, int leds)
+	{
+		for (; leds > 0; leds--, index += step, input += (extraByte) ? 4 : 3)
+		{
+			decodeColor<extraByte, correction>(input);
+			strip->SetPixel(index, frameState.color);
+		}
+	});
+}
+
+/**
+ * @brief Decode a contiguous run of complete pixels of the current protocol version
+ *
+ * @param input
+ * @param pixels
+ */
+inline void decodePixelSpan(const volatile uint8_t* input, int pixels)
+{
+	if (colorLut.isEnabled())
+	{
+		if (frameState.isProtocolVersion3())
+			decodePixelSpan<true, true>(input, pixels);
+		else
+			decodePixelSpan<false, true>(input, pixels);
+	}
+	else if (frameState.isProtocolVersion3())
+		decodePixelSpan<true, false>(input, pixels);
+	else
+		decodePixelSpan<false, false>(input, pixels);
+}
+
+#if defined(DITHERING_RENDER)
+	/**
+	 * @brief Decode one pixel of the high precision frame (16-bit channels, high byte first) to frameState.highPrecisionColor
+	 *
+	 * @param input
+	 */
+	inline void decodeHighPrecisionColor(const volatile uint8_t* input)
+	{
+		ColorHighPrecision& color = frameState.highPrecisionColor;
+
+		color.R = colorLut.correctHighPrecision(0, (input[0] << 8) | input[1]);
+		color.G = colorLut.correctHighPrecision(1, (input[2] << 8) | input[3]);
+		color.B = colorLut.correctHighPrecision(2, (input[4] << 8) | input[5]);
+
+		#ifdef NEOPIXEL_RGBW
+			// the white channel is computed in the high precision too, the dithering follows it
+			frameState.rgb2rgbwHighPrecision();
+		#endif
+	}
+
+	/**
+	 * @brief Decode a contiguous run of complete pixels of the high precision frame directly from the ring buffer
+	 *
+	 * @param input
+	 * @param pixels
+	 */
+	inline void decodeHighPrecisionSpan(const volatile uint8_t* input, int pixels)
+	{
+		base.setStripPixels(frameState.advanceLedIndex(pixels), pixels, [&](auto* strip, int index, int step, int leds)
+		{
+			for (; leds > 0; leds--, index += step, input += 6)
+			{
+				decodeHighPrecisionColor(input);
+				strip->SetPixel(index, frameState.highPrecisionColor);
+			}
+		});
+	}
+#endif
+
+/**
+ * @brief Compressed frame: set the next pixels to the same color
+ *
+ * @param pixels
+ * @param color
+ */
+inline void fillPixels(int pixels, const ColorDefinition& color)
+{
+	base.setStripPixels(frameState.advanceLedIndex(pixels), pixels, [&](auto* strip, int index, int step, int leds)
+	{
+		for (; leds > 0; leds--, index += step)
+			strip->SetPixel(index, color);
+	});
+}
+
+/**
+ * @brief Compressed frame: decode the palette indexes
+ *
+ * @param input
+ * @param pixels
+ * @return false if any index is outside the palette
+ */
+inline bool decodePaletteSpan(const volatile uint8_t* input, int pixels)
+{
+	for (int i = 0; i < pixels; i++)
+		if (input[i] >= frameState.compressed.paletteSize)
+			return false;
+
+	base.setStripPixels(frameState.advanceLedIndex(pixels), pixels, [&](auto* strip, int index, int step, int leds)
+	{
+		for (; leds > 0; leds--, index += step)
+			strip->SetPixel(index, frameState.compressed.palette[*(input++)]);
+	});
+
+	return true;
+}
+
+/**
+ * @brief Decode as many complete pixels as possible in one run: up to the ring wrap or the end of the frame
+ *
+ * @return true if any pixel was decoded
+ */
+inline bool processPixelSpan()
+{
+	int pixelSize = (frameState.isHighPrecisionFrame()) ? 6 : ((frameState.isProtocolVersion3()) ? 4 : 3);
+	uint32_t available;
+	const uint8_t* input = base.ring.getReadSpan(available);
+	int pixels = std::min((int)available / pixelSize, frameState.getRemainingLeds());
+
+	if (pixels <= 0)
+		return false;
+
+	frameState.addFletcher(input, pixels * pixelSize);
+
+	#if defined(DITHERING_RENDER)
+		if (frameState.isHighPrecisionFrame())
+			decodeHighPrecisionSpan(input, pixels);
+		else
+	#endif
+	decodePixelSpan(input, pixels);
+
+	base.ring.consume(pixels * pixelSize);
+
+	// the ranges of the delta frame are applied to the last frame, they can't be streamed
+	if (!frameState.isDeltaFrame())
+		base.streamPixels(frameState.getDecodedLeds());
+
+	if (frameState.getRemainingLeds() == 0)
+		finishPixelRun();
+
+	return true;
+}
+
+/**
+ * @brief Compressed frame: decode as many complete tokens as possible in one run (up to the ring wrap).
+ *        The token that doesn't fit is left for the state machine.
+ *
+ * @return true if any input was consumed
+ */
+inline bool processCompressedSpan()
+{
+	const int pixelSize = (frameState.isProtocolVersion3()) ? 4 : 3;
+	uint32_t span;
+	const uint8_t* input = base.ring.getReadSpan(span);
+	int available = span;
+	int used = 0;
+	bool broken = false;
+
+	while (frameState.getFrameRemainingLeds() > 0 && used < available)
+	{
+		uint8_t token = input[used];
+		int pixels = (token < COMPRESSED_TOKEN_RUN) ? token + 1 : (token & 0x3f) + 1;
+		int tokenSize = 1 + ((token < COMPRESSED_TOKEN_RUN) ? pixels * pixelSize : ((token < COMPRESSED_TOKEN_INDEXES) ? pixelSize : pixels));
+
+		if (pixels > frameState.getFrameRemainingLeds())
+		{
+			broken = true;
+			break;
+		}
+
+		if (used + tokenSize > available)
+			break;
+
+		const uint8_t* data = input + used + 1;
+
+		if (token < COMPRESSED_TOKEN_RUN)
+			decodePixelSpan(data, pixels);
+		else if (token < COMPRESSED_TOKEN_INDEXES)
+		{
+			decodeColor(data);
+			fillPixels(pixels, frameState.color);
+		}
+		else if (!decodePaletteSpan(data, pixels))
+		{
+			broken = true;
+			break;
+		}
+
+		used += tokenSize;
+	}
+
+	// the rejected frame must not restart the stream: the resync scans its bytes for the next header
+	if (broken)
+	{
+		base.abortStream();
+		frameState.setState(AwaProtocol::HEADER_A);
+		return true;
+	}
+
+	if (used == 0)
+		return false;
+
+	frameState.addFletcher(input, used);
+	base.ring.consume(used);
+	base.streamPixels(frameState.getDecodedLeds());
+
+	if (frameState.getFrameRemainingLeds() == 0)
+		frameState.setState(AwaProtocol::FLETCHER1);
+
+	return true;
+}
+
+/**
+ * @brief Find the next 'A' byte: a word at a time, the 'A' byte is zero after XOR with 0x41414141
+ *
+ * @param input
+ * @param position start of the search
+ * @param length
+ * @return position of the 'A' byte or length if there is none
+ */
+inline uint32_t findHeaderStart(const uint8_t* input, uint32_t position, uint32_t length)
+{
+	for (; position < length && ((uintptr_t)(input + position) & 3) != 0; position++)
+		if (input[position] == 'A')
+			return position;
+
+	for (; position + 4 <= length; position += 4)
+	{
+		uint32_t word;
+		memcpy(&word, __builtin_assume_aligned(input + position, 4), 4);
+		word ^= 0x41414141;
+
+		if (((word - 0x01010101) & ~word & 0x80808080) != 0)
+			break;
+	}
+
+	for (; position < length; position++)
+		if (input[position] == 'A')
+			return position;
+
+	return length;
+}
+
+/**
+ * @brief Known variant of the frame header, the byte after 'w' (protocol version 1, 2) or 'W' (protocol version 3).
+ *        Shared by the state machine and the resync scanner
+ *
+ * @param version 'w' or 'W'
+ * @param variant
+ * @return true if this build accepts it
+ */
+inline bool isHeaderVariant(uint8_t version, uint8_t variant)
+{
+	if (version == 'w')
+	{
+		#if defined(DITHERING_RENDER)
+			if (variant == 'h')
+				return true;
+		#endif
+
+		return variant == 'a' || variant == 'A' || variant == 'd' || variant == 'c';
+	}
+
+	#if defined(NEOPIXEL_RGBW) || defined(SPILED_APA102)
+		if (version == 'W')
+			return variant == 'a' || variant == 'd' || variant == 'c';
+	#endif
+
+	return false;
+}
+
+/**
+ * @brief Known command of the control frame (the 0x2aa2 count is followed by the command instead of the CRC)
+ *
+ * @param command
+ * @return true if this build handles it
+ */
+inline bool isControlCommand(uint8_t command)
+{
+	#if defined(HYPERSERIAL_PROFILE)
+		if (command == COMMAND_PROFILE)
+			return true;
+	#endif
+
+	#if defined(SEGMENT_INDEXES)
+		if (command == COMMAND_SEGMENTS_LAYOUT)
+			return true;
+	#endif
+
+	return command == COMMAND_STATISTICS || command == COMMAND_STATISTICS_SILENT || command == COMMAND_STATISTICS_BINARY ||
+			command == COMMAND_COLOR_LUT;
+}
+
+/**
+ * @brief Valid LED count of the frame header and its CRC (or the control frame and its command).
+ *        Shared by the state machine and the resync scanner
+ *
+ * @param count LED count - 1
+ * @param crc the last header byte
+ * @return true if the header is accepted
+ */
+inline bool isHeaderCount(uint16_t count, uint8_t crc)
+{
+	if (count == 0x2aa2)
+		return isControlCommand(crc);
+
+	return crc == ((count >> 8) ^ (count & 0xff) ^ 0x55) && count < 4096;
+}
+
+/**
+ * @brief Verify the complete header candidate (6 bytes) the same way as the state machine does
+ *
+ * @param header
+ * @return true if the state machine would accept it
+ */
+inline bool isHeaderCandidate(const uint8_t* header)
+{
+	return header[0] == 'A' && isHeaderVariant(header[1], header[2]) && isHeaderCount((header[3] << 8) | header[4], header[5]);
+}
+
+/**
+ * @brief The state machine has rejected the header: its bytes count to the resync like the skipped ones
+ *
+ * @param bytes
+ */
+inline void rejectHeader(uint32_t bytes)
+{
+	statistics.addResyncDiscarded(bytes);
+	frameState.setState(AwaProtocol::HEADER_A);
+}
+
+/**
+ * @brief Resync: skip the bytes that can't start a valid header in one run (up to the ring wrap).
+ *        The candidate that is incomplete in the span is left for the state machine.
+ *
+ * @return true if any input was discarded
+ */
+inline bool skipToHeader()
+{
+	uint32_t available;
+	const uint8_t* input = base.ring.getReadSpan(available);
+	uint32_t position = 0;
+
+	while ((position = findHeaderStart(input, position, available)) + 6 <= available && !isHeaderCandidate(input + position))
+		position++;
+
+	position = std::min(position, available);
+
+	if (position == 0)
+		return false;
+
+	base.ring.consume(position);
+	statistics.addResyncDiscarded(position);
+
+	return true;
+}
+
 /**
  * @brief process received data on core 0
  *
@@ -54,27 +516,41 @@ void processData()
 	unsigned long currentTime = millis();
 	unsigned long deltaTime = currentTime - statistics.getStartTime();
 
-	updateMainStatistics(currentTime, deltaTime, base.queueCurrent != base.queueEnd);
-
-	if (statistics.getStartTime() + 5000 < millis())
+	// the frame timeout before the new data restarts the statistics period
+	if (statistics.checkTimeout(currentTime))
 	{
+		base.abortStream();
 		frameState.setState(AwaProtocol::HEADER_A);
 	}
 
+	updateMainStatistics(currentTime, deltaTime, !base.ring.isEmpty());
+
 	// render waiting frame if available
 	if (base.hasLateFrameToRender())
 		base.renderLeds(false);
 
 	// process received data
-	while (base.queueCurrent != base.queueEnd)
+	while (!base.ring.isEmpty())
 	{
-		uint8_t input = base.buffer[base.queueCurrent++];
+		// the pixel payload is decoded in bulk, the state machine handles only headers, trailers and split pixels
+		if (frameState.getState() == AwaProtocol::RED && processPixelSpan())
+			continue;
 
-		if (base.queueCurrent >= MAX_BUFFER)
-		{
-			base.queueCurrent = 0;
-			yield();
-		}
+		if (frameState.getState() == AwaProtocol::COMPRESSED_TOKEN && processCompressedSpan())
+			continue;
+
+		#if defined(DITHERING_RENDER)
+			if (frameState.getState() == AwaProtocol::HIGH_PRECISION_PIXEL && frameState.highPrecision.received == 0 && processPixelSpan())
+				continue;
+		#endif
+
+		if (frameState.getState() == AwaProtocol::HEADER_A && skipToHeader())
+			continue;
+
+		uint8_t input = base.ring.pop();
+
+		// the header bytes up to the CRC byte, which starts the frame
+		PROFILE_SCOPE_IF(header, frameState.getState() <= AwaProtocol::HEADER_LO);
 
 		switch (frameState.getState())
 		{
@@ -82,8 +558,13 @@ void processData()
 			// assume it's protocol version 1, verify it later
 			frameState.setProtocolVersion2(false);
 			frameState.setProtocolVersion3(false);			
+			frameState.setDeltaFrame(false);
+			frameState.setCompressedFrame(false);
+			frameState.setHighPrecisionFrame(false);
 			if (input == 'A')
 				frameState.setState(AwaProtocol::HEADER_w);
+			else
+				rejectHeader(1);
 			break;
 
 		case AwaProtocol::HEADER_w:
@@ -94,35 +575,65 @@ void processData()
 				frameState.setState(AwaProtocol::HEADER_W);
 #endif
 			else
-				frameState.setState(AwaProtocol::HEADER_A);
+				rejectHeader(2);
 			break;
 		case AwaProtocol::HEADER_W:
 			// detect protocol version 3
-			if (input == 'a')			
+			if (!isHeaderVariant('W', input))
+				rejectHeader(3);
+			else if (input == 'a')			
 			{
 				frameState.setState(AwaProtocol::HEADER_HI);
 				frameState.setProtocolVersion3(true);
 			}				
-			else
-				frameState.setState(AwaProtocol::HEADER_A);
+			else if (input == 'd')
+			{
+				frameState.setState(AwaProtocol::HEADER_HI);
+				frameState.setProtocolVersion3(true);
+				frameState.setDeltaFrame(true);
+			}
+			else if (input == 'c')
+			{
+				frameState.setState(AwaProtocol::HEADER_HI);
+				frameState.setProtocolVersion3(true);
+				frameState.setCompressedFrame(true);
+			}
 			break;
 
 		case AwaProtocol::HEADER_a:
 			// detect protocol version
-			if (input == 'a')
+			if (!isHeaderVariant('w', input))
+				rejectHeader(3);
+			else if (input == 'a')
 				frameState.setState(AwaProtocol::HEADER_HI);
 			else if (input == 'A')
 			{
 				frameState.setState(AwaProtocol::HEADER_HI);
 				frameState.setProtocolVersion2(true);
 			}
-			else
-				frameState.setState(AwaProtocol::HEADER_A);
+			else if (input == 'd')
+			{
+				frameState.setState(AwaProtocol::HEADER_HI);
+				frameState.setDeltaFrame(true);
+			}
+			else if (input == 'c')
+			{
+				frameState.setState(AwaProtocol::HEADER_HI);
+				frameState.setCompressedFrame(true);
+			}
+#if defined(DITHERING_RENDER)
+			else if (input == 'h')
+			{
+				frameState.setState(AwaProtocol::HEADER_HI);
+				frameState.setHighPrecisionFrame(true);
+			}
+#endif
 			break;
 
 		case AwaProtocol::HEADER_HI:
 			// initialize new frame properties
 			statistics.increaseTotal();
+			statistics.markFrameHeader();
 			frameState.init(input);
 			frameState.setState(AwaProtocol::HEADER_LO);
 			break;
@@ -133,39 +644,247 @@ void processData()
 			break;
 
 		case AwaProtocol::HEADER_CRC:
-			// verify CRC and create/update LED driver if neccesery
-			if (frameState.getCRC() == input)
+			// verify CRC (or the command of the control frame) the same way as the resync scanner
+			if (!isHeaderCount(frameState.getCount(), input))
+			{
+				rejectHeader(6);
+				break;
+			}
+
+			// create/update LED driver if neccesery
+			if (frameState.getCount() != 0x2aa2)
 			{
 				uint16_t ledSize = frameState.getCount() + 1;
 
-				// sanity check
-				if (ledSize > 4096)
-					frameState.setState(AwaProtocol::HEADER_A);
+				statistics.markHeaderSynced();
+
+				if (ledSize != base.getLedsNumber())
+					base.initLedStrip(ledSize);
+
+				base.beginFrame(frameState.isDeltaFrame());
+
+				if (frameState.isDeltaFrame())
+					frameState.setState(AwaProtocol::DELTA_OFFSET_HI);
 				else
 				{
-					if (ledSize != base.getLedsNumber())
-						base.initLedStrip(ledSize);
+					frameState.startRange(0, ledSize);
 
-					frameState.setState(AwaProtocol::RED);
+					if (frameState.isCompressedFrame())
+						frameState.setState(AwaProtocol::COMPRESSED_PALETTE_SIZE);
+					#if defined(DITHERING_RENDER)
+						else if (frameState.isHighPrecisionFrame())
+						{
+							frameState.highPrecision.received = 0;
+							frameState.setState(AwaProtocol::HIGH_PRECISION_PIXEL);
+						}
+					#endif
+					else
+						frameState.setState(AwaProtocol::RED);
 				}
 			}
-			else if (frameState.getCount() ==  0x2aa2 && (input == 0x15 || input == 0x35))
+			else if (input == COMMAND_STATISTICS || input == COMMAND_STATISTICS_SILENT || input == COMMAND_STATISTICS_BINARY)
 			{
-				statistics.print(currentTime, base.processDataHandle, base.processSerialHandle);
+				// the report is queued, core0 sends it when it's idle
+				statistics.setRingState(base.ring.capacity(), base.ring.getDropped());
+
+				if (input == COMMAND_STATISTICS_BINARY)
+					statistics.sendRecord(base.processDataHandle, base.processSerialHandle);
+				else
+					statistics.print(currentTime, base.processDataHandle, base.processSerialHandle);
 
-				if (input == 0x15)
-					printf(HELLO_MESSAGE);
+				if (input == COMMAND_STATISTICS)
+					logger.write(HELLO_MESSAGE);
 
 				frameState.setRegroup(true);
 
-				delay(10);
-
 				currentTime = millis();
 				statistics.reset(currentTime);
 				frameState.setState(AwaProtocol::HEADER_A);
 			}
+			#if defined(HYPERSERIAL_PROFILE)
+				else if (input == COMMAND_PROFILE)
+				{
+					profiler.sendRecord();
+					frameState.setState(AwaProtocol::HEADER_A);
+				}
+			#endif
+			else if (input == COMMAND_COLOR_LUT)
+			{
+				// payload: red, green and blue tables (256 bytes each), Fletcher checksums
+				frameState.setColorLutFrame(true);
+				colorLut.beginUpload();
+				frameState.setState(AwaProtocol::COLOR_LUT_DATA);
+			}
+			#if defined(SEGMENT_INDEXES)
+				else if (input == COMMAND_SEGMENTS_LAYOUT)
+				{
+					// payload: lanes, starting indexes of the next segments (hi, lo), reversed lanes mask, Fletcher checksums
+					frameState.setSegmentsLayoutFrame(true);
+					frameState.setState(AwaProtocol::SEGMENTS_LANES);
+				}
+			#endif
+			break;
+
+		case AwaProtocol::SEGMENTS_LANES:
+			#if defined(SEGMENT_INDEXES)
+				frameState.addFletcher(input);
+				frameState.segmentsLayout.lanes = input;
+				frameState.segmentsLayout.received = 0;
+
+				if (input >= 1 && input <= MAX_SEGMENTS)
+				{
+					frameState.setState(AwaProtocol::SEGMENTS_DATA);
+					break;
+				}
+			#endif
+			frameState.setState(AwaProtocol::HEADER_A);
+			break;
+
+		case AwaProtocol::SEGMENTS_DATA:
+			#if defined(SEGMENT_INDEXES)
+				frameState.addFletcher(input);
+				frameState.segmentsLayout.data[frameState.segmentsLayout.received++] = input;
+
+				if (frameState.segmentsLayout.received == frameState.segmentsLayout.size())
+					frameState.setState(AwaProtocol::FLETCHER1);
+			#else
+				frameState.setState(AwaProtocol::HEADER_A);
+			#endif
+			break;
+
+		case AwaProtocol::COLOR_LUT_DATA:
+			frameState.addFletcher(input);
+
+			if (colorLut.addUpload(input))
+				frameState.setState(AwaProtocol::FLETCHER1);
+			break;
+
+		case AwaProtocol::DELTA_OFFSET_HI:
+			frameState.addFletcher(input);
+			frameState.deltaRange.offset = input << 8;
+
+			frameState.setState(AwaProtocol::DELTA_OFFSET_LO);
+			break;
+
+		case AwaProtocol::DELTA_OFFSET_LO:
+			frameState.addFletcher(input);
+			frameState.deltaRange.offset |= input;
+
+			frameState.setState(AwaProtocol::DELTA_LENGTH_HI);
+			break;
+
+		case AwaProtocol::DELTA_LENGTH_HI:
+			frameState.addFletcher(input);
+			frameState.deltaRange.length = input << 8;
+
+			frameState.setState(AwaProtocol::DELTA_LENGTH_LO);
+			break;
+
+		case AwaProtocol::DELTA_LENGTH_LO:
+			frameState.addFletcher(input);
+			frameState.deltaRange.length |= input;
+
+			// the empty range ends the list, the range must fit in the strip
+			if (frameState.deltaRange.length == 0)
+				frameState.setState(AwaProtocol::FLETCHER1);
+			else if (frameState.deltaRange.offset + frameState.deltaRange.length > base.getLedsNumber())
+				frameState.setState(AwaProtocol::HEADER_A);
+			else
+			{
+				frameState.startRange(frameState.deltaRange.offset, frameState.deltaRange.length);
+				frameState.setState(AwaProtocol::RED);
+			}
+			break;
+
+		case AwaProtocol::COMPRESSED_PALETTE_SIZE:
+			frameState.addFletcher(input);
+			frameState.compressed.paletteSize = input;
+			frameState.compressed.received = 0;
+			frameState.compressed.pixels = 0;
+
+			if (input > COMPRESSED_PALETTE_COLORS)
+				frameState.setState(AwaProtocol::HEADER_A);
 			else
+				frameState.setState((input > 0) ? AwaProtocol::COMPRESSED_PALETTE : AwaProtocol::COMPRESSED_TOKEN);
+			break;
+
+		case AwaProtocol::COMPRESSED_PALETTE:
+			// the palette colors are converted once, 'pixels' counts the bytes of the current color
+			frameState.addFletcher(input);
+			frameState.compressed.colorBytes[frameState.compressed.pixels++] = input;
+
+			if (frameState.compressed.pixels == ((frameState.isProtocolVersion3()) ? 4 : 3))
+			{
+				decodeColor(frameState.compressed.colorBytes);
+				frameState.compressed.palette[frameState.compressed.received++] = frameState.color;
+				frameState.compressed.pixels = 0;
+
+				if (frameState.compressed.received == frameState.compressed.paletteSize)
+					frameState.setState(AwaProtocol::COMPRESSED_TOKEN);
+			}
+			break;
+
+		case AwaProtocol::COMPRESSED_TOKEN:
+			frameState.addFletcher(input);
+			frameState.compressed.pixels = (input < COMPRESSED_TOKEN_RUN) ? input + 1 : (input & 0x3f) + 1;
+			frameState.compressed.received = 0;
+
+			if (frameState.compressed.pixels > frameState.getFrameRemainingLeds())
+			{
+				base.abortStream();
 				frameState.setState(AwaProtocol::HEADER_A);
+			}
+			else if (input < COMPRESSED_TOKEN_RUN)
+			{
+				// the literal pixels are decoded as the regular frame
+				frameState.startRange(frameState.getDecodedLeds(), frameState.compressed.pixels);
+				frameState.setState(AwaProtocol::RED);
+			}
+			else
+				frameState.setState((input < COMPRESSED_TOKEN_INDEXES) ? AwaProtocol::COMPRESSED_RUN_COLOR : AwaProtocol::COMPRESSED_INDEX);
+			break;
+
+		case AwaProtocol::COMPRESSED_RUN_COLOR:
+			frameState.addFletcher(input);
+			frameState.compressed.colorBytes[frameState.compressed.received++] = input;
+
+			if (frameState.compressed.received == ((frameState.isProtocolVersion3()) ? 4 : 3))
+			{
+				decodeColor(frameState.compressed.colorBytes);
+				fillPixels(frameState.compressed.pixels, frameState.color);
+				finishPixelRun();
+			}
+			break;
+
+		case AwaProtocol::COMPRESSED_INDEX:
+			frameState.addFletcher(input);
+
+			if (!decodePaletteSpan(&input, 1))
+			{
+				base.abortStream();
+				frameState.setState(AwaProtocol::HEADER_A);
+			}
+			else if (--frameState.compressed.pixels == 0)
+				finishPixelRun();
+			break;
+
+		case AwaProtocol::HIGH_PRECISION_PIXEL:
+			// the pixel split by the ring wrap or the USB packet
+			#if defined(DITHERING_RENDER)
+				frameState.addFletcher(input);
+				frameState.highPrecision.colorBytes[frameState.highPrecision.received++] = input;
+
+				if (frameState.highPrecision.received == 6)
+				{
+					frameState.highPrecision.received = 0;
+					decodeHighPrecisionSpan(frameState.highPrecision.colorBytes, 1);
+
+					if (frameState.getRemainingLeds() == 0)
+						finishPixelRun();
+				}
+			#else
+				frameState.setState(AwaProtocol::HEADER_A);
+			#endif
 			break;
 
 		case AwaProtocol::RED:
@@ -190,20 +909,25 @@ void processData()
 			#endif
 			frameState.addFletcher(input);
 
-			if (base.setStripPixel(frameState.getCurrentLedIndex(), frameState.color))
-			{
+			base.setStripPixel(frameState.getCurrentLedIndex(), frameState.color);
+
+			if (frameState.getRemainingLeds() > 0)
 				frameState.setState(AwaProtocol::RED);
-			}
 			else
-			{
-				frameState.setState(AwaProtocol::FLETCHER1);
-			}
+				finishPixelRun();
 			break;			
 
 		case AwaProtocol::BLUE:
 			frameState.color.B = input;
 			frameState.addFletcher(input);
 
+			if (colorLut.isEnabled())
+			{
+				frameState.color.R = colorLut.correct<true>(0, frameState.color.R);
+				frameState.color.G = colorLut.correct<true>(1, frameState.color.G);
+				frameState.color.B = colorLut.correct<true>(2, frameState.color.B);
+			}
+
 			if (frameState.isProtocolVersion3())
 			{
 				frameState.setState(AwaProtocol::EXTRA_COLOR_BYTE_4);
@@ -219,18 +943,13 @@ void processData()
 				frameState.rgb2rgbw();
 			#endif
 
-			// set pixel, increase the index and check if it was the last LED color to come
-			if (base.setStripPixel(frameState.getCurrentLedIndex(), frameState.color))
-			{
+			// set pixel, increase the index and check if it was the last LED color of the run
+			base.setStripPixel(frameState.getCurrentLedIndex(), frameState.color);
+
+			if (frameState.getRemainingLeds() > 0)
 				frameState.setState(AwaProtocol::RED);
-			}
 			else
-			{
-				if (frameState.isProtocolVersion2())
-					frameState.setState(AwaProtocol::VERSION2_GAIN);
-				else
-					frameState.setState(AwaProtocol::FLETCHER1);
-			}
+				finishPixelRun();
 
 			break;
 
@@ -265,7 +984,10 @@ void processData()
 		case AwaProtocol::FLETCHER1:
 			// initial frame data integrity check
 			if (input != frameState.getFletcher1())
+			{
+				base.abortStream();
 				frameState.setState(AwaProtocol::HEADER_A);
+			}
 			else
 				frameState.setState(AwaProtocol::FLETCHER2);
 			break;
@@ -273,16 +995,38 @@ void processData()
 		case AwaProtocol::FLETCHER2:
 			// initial frame data integrity check
 			if (input != frameState.getFletcher2())
+			{
+				base.abortStream();
 				frameState.setState(AwaProtocol::HEADER_A);
+			}
 			else
 				frameState.setState(AwaProtocol::FLETCHER_EXT);
 			break;
 
 		case AwaProtocol::FLETCHER_EXT:
 			// final frame data integrity check
+			#if defined(SEGMENT_INDEXES)
+				if (input == frameState.getFletcherExt() && frameState.isSegmentsLayoutFrame())
+				{
+					if (frameState.updateIncomingSegmentsLayout())
+						logger.printf("\r\nSegments layout: %i lanes\r\n", frameState.segmentsLayout.lanes);
+
+					frameState.setState(AwaProtocol::HEADER_A);
+					break;
+				}
+			#endif
+
+			if (input == frameState.getFletcherExt() && frameState.isColorLutFrame())
+			{
+				colorLut.commitUpload();
+				frameState.setState(AwaProtocol::HEADER_A);
+				break;
+			}
+
 			if (input == frameState.getFletcherExt())
 			{
 				statistics.increaseGood();
+				statistics.markFrameValid();
 
 				base.renderLeds(true);
 
@@ -297,9 +1041,9 @@ void processData()
 				currentTime = millis();
 				deltaTime = currentTime - statistics.getStartTime();
 				updateMainStatistics(currentTime, deltaTime, true);
-
-				yield();
 			}
+			else
+				base.abortStream();
 
 			frameState.setState(AwaProtocol::HEADER_A);
 			break;
@@ -0,0 +1,159 @@
+/* profile.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#if defined(HYPERSERIAL_PROFILE)
+
+#include <hardware/structs/systick.h>
+#include "telemetry.h"
+
+#define TELEMETRY_PROFILE_VERSION 1
+
+// profiled stages of core1, the telemetry record keeps this order
+enum class ProfileStage
+{
+	header,
+	fletcher,
+	rgb2rgbw,
+	setPixel,
+	frameCopy,
+	stripWait,
+	count
+};
+
+// clock, number of stages, then calls and cycles of every stage
+#define TELEMETRY_PROFILE_PAYLOAD (4 + 1 + (4 + 8) * (int)ProfileStage::count)
+
+static_assert(TELEMETRY_PROFILE_PAYLOAD <= TELEMETRY_MAX_PAYLOAD, "The profile record doesn't fit the telemetry payload");
+
+/**
+ * @brief Cycles and calls of the profiled stages. The cycles are counted by the SysTick of core1
+ *        (Cortex-M0+ has no cycle counter): 24-bit down counter at the processor clock,
+ *        so a single measured call must be shorter than 2^24 cycles (134ms at 125MHz).
+ *
+ */
+class
+{
+	uint64_t cycles[(int)ProfileStage::count] = {};
+	uint32_t calls[(int)ProfileStage::count] = {};
+
+	public:
+		/**
+		 * @brief Start the free running SysTick of the calling core (core1)
+		 *
+		 */
+		void begin()
+		{
+			systick_hw->csr = 0;
+			systick_hw->rvr = 0xffffff;
+			systick_hw->cvr = 0;
+			// processor clock, no interrupt
+			systick_hw->csr = 0x5;
+		}
+
+		static inline uint32_t now()
+		{
+			return systick_hw->cvr;
+		}
+
+		/**
+		 * @brief Add the call of the stage
+		 *
+		 * @param stage
+		 * @param start SysTick value at the beginning
+		 */
+		inline void add(ProfileStage stage, uint32_t start)
+		{
+			// the counter runs down
+			cycles[(int)stage] += (start - now()) & 0xffffff;
+			calls[(int)stage]++;
+		}
+
+		inline uint64_t getCycles(ProfileStage stage)
+		{
+			return cycles[(int)stage];
+		}
+
+		inline uint32_t getCalls(ProfileStage stage)
+		{
+			return calls[(int)stage];
+		}
+
+		/**
+		 * @brief Send the totals since the start as the telemetry record.
+		 *        Payload: processor clock [Hz] (4 bytes), number of stages, then calls (4 bytes) and cycles (8 bytes) of every stage
+		 *
+		 */
+		void sendRecord()
+		{
+			TelemetryRecord record(TELEMETRY_PROFILE, TELEMETRY_PROFILE_VERSION);
+
+			record.put32(clock_get_hz(clk_sys));
+			record.put8((uint8_t)ProfileStage::count);
+
+			for (int i = 0; i < (int)ProfileStage::count; i++)
+			{
+				record.put32(calls[i]);
+				record.put64(cycles[i]);
+			}
+
+			record.send();
+		}
+} profiler;
+
+class ProfileScope
+{
+	ProfileStage stage;
+	uint32_t start;
+	bool active;
+
+	public:
+		inline ProfileScope(ProfileStage _stage, bool _active = true) : stage(_stage), start(profiler.now()), active(_active)
+		{
+		}
+
+		inline ~ProfileScope()
+		{
+			if (active)
+				profiler.add(stage, start);
+		}
+};
+
+// measure the rest of the block (if the condition is true at its start)
+#define PROFILE_SCOPE(stage) ProfileScope profileScope(ProfileStage::stage)
+#define PROFILE_SCOPE_IF(stage, condition) ProfileScope profileScope(ProfileStage::stage, condition)
+
+#else
+
+#define PROFILE_SCOPE(stage)
+#define PROFILE_SCOPE_IF(stage, condition)
+
+#endif
+
+#endif
@@ -0,0 +1,237 @@
+/* ringbuffer.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Lock-free single producer (core0: USB receiver) / single consumer (core1: parser) ring buffer.
+ *        The producer publishes the written bytes by the release store of the write index, the consumer
+ *        frees the read bytes by the release store of the read index, the other side loads them with
+ *        the acquire ordering. One byte is always kept free to tell the full buffer from the empty one.
+ *        Both sides can work on contiguous spans up to the end of the ring.
+ *
+ * @tparam SIZE
+ */
+template<uint32_t SIZE>
+class RingBuffer
+{
+	uint8_t data[SIZE];
+	std::atomic<uint32_t> writeIndex{0};
+	std::atomic<uint32_t> readIndex{0};
+	// written by the producer only: no read-modify-write atomics needed (not available on Cortex-M0+)
+	std::atomic<uint32_t> dropped{0};
+	// the consumer's last view of the write index, refreshed only when it runs out of the data
+	uint32_t consumerWriteIndex = 0;
+
+	static inline uint32_t advance(uint32_t index, uint32_t length)
+	{
+		index += length;
+		return (index >= SIZE) ? index - SIZE : index;
+	}
+
+	public:
+		static constexpr uint32_t capacity()
+		{
+			return SIZE - 1;
+		}
+
+		/**
+		 * @brief Producer: the free contiguous space at the write position
+		 *
+		 * @param length [out] up to the end of the ring or the unread data
+		 * @return uint8_t*
+		 */
+		inline uint8_t* getWriteSpan(uint32_t& length)
+		{
+			uint32_t write = writeIndex.load(std::memory_order_relaxed);
+			uint32_t read = readIndex.load(std::memory_order_acquire);
+
+			length = (read > write) ? read - write - 1 : SIZE - write - ((read == 0) ? 1 : 0);
+			return &data[write];
+		}
+
+		/**
+		 * @brief Producer: all free space (both spans)
+		 *
+		 * @return uint32_t
+		 */
+		inline uint32_t getFreeSpace()
+		{
+			uint32_t write = writeIndex.load(std::memory_order_relaxed);
+			uint32_t read = readIndex.load(std::memory_order_acquire);
+
+			return (read > write) ? read - write - 1 : SIZE - write + read - 1;
+		}
+
+		/**
+		 * @brief Producer: publish the bytes written to the span
+		 *
+		 * @param length
+		 */
+		inline void commitWrite(uint32_t length)
+		{
+			writeIndex.store(advance(writeIndex.load(std::memory_order_relaxed), length), std::memory_order_release);
+		}
+
+		/**
+		 * @brief Producer: the position of the next written byte
+		 *
+		 * @return uint32_t
+		 */
+		inline uint32_t getWritePosition()
+		{
+			return writeIndex.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Producer: the data that doesn't fit was dropped (the unread bytes are never overwritten)
+		 *
+		 * @param length
+		 */
+		inline void addDropped(uint32_t length)
+		{
+			dropped.store(dropped.load(std::memory_order_relaxed) + length, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Producer: copy the data to the ring, the bytes that don't fit are dropped and counted
+		 *
+		 * @param source
+		 * @param length
+		 * @return uint32_t written bytes
+		 */
+		uint32_t write(const uint8_t* source, uint32_t length)
+		{
+			uint32_t written = 0;
+
+			while (written < length)
+			{
+				uint32_t span;
+				uint8_t* target = getWriteSpan(span);
+
+				span = std::min(span, length - written);
+				if (span == 0)
+					break;
+
+				memcpy(target, source + written, span);
+				commitWrite(span);
+				written += span;
+			}
+
+			if (written < length)
+				addDropped(length - written);
+
+			return written;
+		}
+
+		/**
+		 * @brief Consumer: no data to read
+		 *
+		 * @return true
+		 */
+		inline bool isEmpty()
+		{
+			uint32_t read = readIndex.load(std::memory_order_relaxed);
+
+			if (read != consumerWriteIndex)
+				return false;
+
+			consumerWriteIndex = writeIndex.load(std::memory_order_acquire);
+			return read == consumerWriteIndex;
+		}
+
+		/**
+		 * @brief Consumer: the contiguous unread data at the read position
+		 *
+		 * @param length [out] up to the end of the ring or the write position
+		 * @return const uint8_t*
+		 */
+		inline const uint8_t* getReadSpan(uint32_t& length)
+		{
+			uint32_t read = readIndex.load(std::memory_order_relaxed);
+
+			consumerWriteIndex = writeIndex.load(std::memory_order_acquire);
+			length = ((consumerWriteIndex >= read) ? consumerWriteIndex : SIZE) - read;
+			return &data[read];
+		}
+
+		/**
+		 * @brief Consumer: the unread bytes before the position that the producer had (getWritePosition)
+		 *
+		 * @param position
+		 * @return uint32_t
+		 */
+		inline uint32_t getReadDistance(uint32_t position)
+		{
+			uint32_t read = readIndex.load(std::memory_order_relaxed);
+
+			return (position >= read) ? position - read : SIZE - read + position;
+		}
+
+		/**
+		 * @brief Consumer: free the bytes that were read from the span
+		 *
+		 * @param length
+		 */
+		inline void consume(uint32_t length)
+		{
+			readIndex.store(advance(readIndex.load(std::memory_order_relaxed), length), std::memory_order_release);
+		}
+
+		/**
+		 * @brief Consumer: read one byte, the buffer must not be empty (isEmpty)
+		 *
+		 * @return uint8_t
+		 */
+		inline uint8_t pop()
+		{
+			uint32_t read = readIndex.load(std::memory_order_relaxed);
+			uint8_t value = data[read];
+
+			readIndex.store(advance(read, 1), std::memory_order_release);
+			return value;
+		}
+
+		/**
+		 * @brief Bytes dropped by the producer because the buffer was full
+		 *
+		 * @return uint32_t
+		 */
+		inline uint32_t getDropped()
+		{
+			return dropped.load(std::memory_order_relaxed);
+		}
+};
+
+#endif
@@ -28,16 +28,192 @@
 #ifndef STATISTICS_H
 #define STATISTICS_H
 
+#include <atomic>
+
+// wake-up latency histogram: bucket 0 up to 1us, bucket n from 2^n us, the last one is open
+#define WAKE_UP_LATENCY_BUCKETS 12
+
+// frame latency histogram: 4 buckets per power of 2 (resolution 12-25%), the last one from 459ms is open
+#define FRAME_LATENCY_BUCKETS 72
+
+#define TELEMETRY_STATISTICS_VERSION 3
+
+// 5 fields of 2 bytes, 24 fields of 4 bytes and 5 of every latency histogram (see sendRecord)
+#define TELEMETRY_STATISTICS_PAYLOAD (5 * 2 + (24 + 4 * 5) * 4)
+
+static_assert(TELEMETRY_STATISTICS_PAYLOAD <= TELEMETRY_MAX_PAYLOAD, "The statistics record doesn't fit the telemetry payload");
+
+class LatencyHistogram
+{
+	uint32_t buckets[FRAME_LATENCY_BUCKETS] = {};
+	uint32_t samples = 0;
+	uint32_t maximum = 0;
+
+	static int getBucket(uint32_t value)
+	{
+		if (value < 4)
+			return value;
+
+		int exponent = 31 - __builtin_clz(value);
+
+		return std::min((exponent - 1) * 4 + (int)((value >> (exponent - 2)) & 3), FRAME_LATENCY_BUCKETS - 1);
+	}
+
+	static uint32_t getBucketStart(int bucket)
+	{
+		return (bucket < 4) ? bucket : (4u + bucket % 4) << (bucket / 4 - 1);
+	}
+
+	public:
+		/**
+		 * @brief Add the sample
+		 *
+		 * @param value [us]
+		 */
+		inline void add(uint64_t value)
+		{
+			uint32_t sample = (uint32_t)std::min(value, (uint64_t)UINT32_MAX);
+
+			buckets[getBucket(sample)]++;
+			maximum = std::max(maximum, sample);
+			samples++;
+		}
+
+		/**
+		 * @brief Get the upper bound of the bucket that contains the percentile
+		 *
+		 * @param percent
+		 * @return uint32_t [us]
+		 */
+		uint32_t getPercentile(uint32_t percent) const
+		{
+			uint64_t rank = ((uint64_t)samples * percent + 99) / 100;
+			uint64_t count = 0;
+
+			for (int i = 0; i < FRAME_LATENCY_BUCKETS - 1; i++)
+				if ((count += buckets[i]) >= rank && count > 0)
+					return std::min(getBucketStart(i + 1) - 1, maximum);
+
+			return maximum;
+		}
+
+		inline uint32_t getMax() const
+		{
+			return maximum;
+		}
+
+		inline uint32_t getSamples() const
+		{
+			return samples;
+		}
+
+		void reset()
+		{
+			std::fill(std::begin(buckets), std::end(buckets), 0);
+			samples = 0;
+			maximum = 0;
+		}
+};
+
+inline int formatStatisticsReport(int line, char* output, int size);
+
+// values of the text report: saved by core1, the lines are formatted by core0 when it sends them
+struct StatisticsReport
+{
+	uint16_t showFrames, totalFrames, goodFrames;
+	int stack1, stack2;
+	size_t heap;
+	uint32_t bufferSwapSaving;
+	uint32_t latchDeferred, latchReclaimed;
+	uint32_t streamedFrames, streamUnderruns, streamRepairs, streamLatched;
+	uint32_t ditheredFrames;
+	uint32_t droppedLateFrames;
+	uint32_t usbReads, usbBytesPerRead, usbMaxBytes, usbStalls;
+	uint32_t ringSize, ringDropped;
+	uint32_t resyncs, resyncBytes, resyncMaxBytes, resyncTime, resyncMaxTime;
+	uint32_t logDropped, logDroppedReports;
+	uint32_t wakeUpLatency[WAKE_UP_LATENCY_BUCKETS];
+	uint32_t wakeUpLatencyMax;
+	// receive, queue, transfer, total: p50, p95, p99, max, frames
+	uint32_t latency[4][5];
+	bool lutEnabled;
+	uint32_t lutUploads;
+	uint8_t gain, red, green, blue;
+};
+
 // statistics (stats sent only when there is no communication)
 class
 {
 	unsigned long startTime = 0;
+	unsigned long timeoutStartTime = ~0ul;
 	uint16_t goodFrames = 0;
 	uint16_t showFrames = 0;
 	uint16_t totalFrames = 0;
 	uint16_t finalGoodFrames = 0;
 	uint16_t finalShowFrames = 0;
 	uint16_t finalTotalFrames = 0;
+	uint32_t bufferSwapSaving = 0;
+	uint32_t ringSize = 0;
+	uint32_t ringDropped = 0;
+	#if defined(STREAMING_RENDER)
+		uint32_t streamedFrames = 0;
+		uint32_t streamUnderruns = 0;
+		uint32_t streamRepairs = 0;
+		uint32_t streamLatched = 0;
+	#endif
+	#if defined(DITHERING_RENDER)
+		uint32_t ditheredFrames = 0;
+	#endif
+	#if defined(RENDER_SCHEDULER)
+		uint32_t droppedLateFrames = 0;
+	#endif
+	uint32_t wakeUpLatency[WAKE_UP_LATENCY_BUCKETS] = {};
+	uint32_t wakeUpLatencyMax = 0;
+	uint32_t wakeUps = 0;
+	// frame latency: header arrival, validation, DMA start and completion of the transfer
+	uint64_t frameHeaderTime = 0;
+	// the validated frame waiting for the renderer and the submitted frame waiting for the DMA (valid 0: still streaming)
+	uint64_t pendingHeaderTime = 0;
+	uint64_t pendingValidTime = 0;
+	uint64_t sentHeaderTime = 0;
+	uint64_t sentValidTime = 0;
+	#if defined(STREAMING_RENDER)
+		uint64_t streamedStart = 0;
+		uint64_t streamedEnd = 0;
+	#endif
+	LatencyHistogram receiveLatency;
+	LatencyHistogram queueLatency;
+	LatencyHistogram transferLatency;
+	LatencyHistogram totalLatency;
+	// USB receiver: the counters are written only by core0 and never cleared, core1 subtracts the values saved at the reset.
+	// The maximum is cleared by core0 when core1 requests it (usbMaxResetRequest != usbMaxResetDone)
+	std::atomic<uint32_t> usbReads{0};
+	std::atomic<uint32_t> usbBytes{0};
+	std::atomic<uint32_t> usbMaxBytes{0};
+	std::atomic<uint32_t> usbStalls{0};
+	std::atomic<uint32_t> usbMaxResetRequest{0};
+	std::atomic<uint32_t> usbMaxResetDone{0};
+	uint32_t usbReadsBase = 0;
+	uint32_t usbBytesBase = 0;
+	uint32_t usbStallsBase = 0;
+	// header resync: from the first discarded byte to the next valid header
+	bool resyncing = false;
+	uint64_t resyncStartTime = 0;
+	uint32_t resyncBytes = 0;
+	uint32_t resyncs = 0;
+	uint32_t resyncTotalBytes = 0;
+	uint32_t resyncMaxBytes = 0;
+	uint64_t resyncTotalTime = 0;
+	uint32_t resyncMaxTime = 0;
+	// the text report waiting for core0
+	StatisticsReport report;
+
+	void addFrameLatency(uint64_t header, uint64_t valid, uint64_t start, uint64_t end)
+	{
+		queueLatency.add((start > valid) ? start - valid : 0);
+		transferLatency.add(end - start);
+		totalLatency.add(end - header);
+	}
 
 	public:
 		/**
@@ -50,6 +226,22 @@ class
 			return startTime;
 		}
 
+		/**
+		 * @brief No new data for 5s since the start of the current period.
+		 *        Reported once: the idle tick builds check it every render tick
+		 *
+		 * @param currentTime
+		 * @return true if the timeout has just expired
+		 */
+		inline bool checkTimeout(unsigned long currentTime)
+		{
+			if (startTime + 5000 >= currentTime || timeoutStartTime == startTime)
+				return false;
+
+			timeoutStartTime = startTime;
+			return true;
+		}
+
 		/**
 		 * @brief Detected new frame
 		 *
@@ -77,6 +269,385 @@ class
 			goodFrames++;
 		}
 
+		#if defined(STREAMING_RENDER)
+			/**
+			 * @brief The frame was sent while it was still arriving
+			 *
+			 */
+			inline void increaseStreamed()
+			{
+				streamedFrames++;
+			}
+
+			/**
+			 * @brief The stream DMA has sent all the pixels that were ready and had to wait for the parser
+			 *
+			 */
+			inline void increaseStreamUnderrun()
+			{
+				streamUnderruns++;
+			}
+
+			/**
+			 * @brief The partially sent frame was broken and replaced by the last good frame
+			 *
+			 */
+			inline void increaseStreamRepair()
+			{
+				streamRepairs++;
+			}
+
+			/**
+			 * @brief The stream was idle longer than the reset time: the LEDs have latched the partial frame,
+			 *        the rest of the frame is sent as the whole frame once it's valid
+			 *
+			 */
+			inline void increaseStreamLatched()
+			{
+				streamLatched++;
+			}
+
+			inline uint32_t getStreamLatched()
+			{
+				return streamLatched;
+			}
+
+			inline uint32_t getStreamUnderruns()
+			{
+				return streamUnderruns;
+			}
+
+			inline uint32_t getStreamRepairs()
+			{
+				return streamRepairs;
+			}
+		#endif
+
+		#if defined(DITHERING_RENDER)
+			/**
+			 * @brief The frame with the fractional parts was sent again to dither it in time
+			 *
+			 */
+			inline void increaseDithered()
+			{
+				ditheredFrames++;
+			}
+
+			inline uint32_t getDitheredFrames()
+			{
+				return ditheredFrames;
+			}
+		#endif
+
+		#if defined(RENDER_SCHEDULER)
+			/**
+			 * @brief The waiting frame was replaced by the next one before the strip was ready
+			 *
+			 */
+			inline void increaseDroppedLate()
+			{
+				droppedLateFrames++;
+			}
+
+			inline uint32_t getDroppedLateFrames()
+			{
+				return droppedLateFrames;
+			}
+		#endif
+
+		/**
+		 * @brief core1 was woken up by the doorbell: the time from the USB callback to the parser start
+		 *
+		 * @param latency [us]
+		 */
+		inline void addWakeUpLatency(uint32_t latency)
+		{
+			int bucket = (latency < 2) ? 0 : std::min(31 - __builtin_clz(latency), WAKE_UP_LATENCY_BUCKETS - 1);
+
+			wakeUpLatency[bucket]++;
+			wakeUpLatencyMax = std::max(wakeUpLatencyMax, latency);
+			wakeUps++;
+		}
+
+		inline uint32_t getWakeUps()
+		{
+			return wakeUps;
+		}
+
+		inline uint32_t getWakeUpLatencyMax()
+		{
+			return wakeUpLatencyMax;
+		}
+
+		/**
+		 * @brief The header of the new frame has arrived
+		 *
+		 */
+		inline void markFrameHeader()
+		{
+			frameHeaderTime = time_us_64();
+		}
+
+		/**
+		 * @brief The frame has passed the checksum: it waits for the renderer.
+		 *        The frame that was waiting before was replaced without being sent on its own.
+		 *
+		 */
+		inline void markFrameValid()
+		{
+			uint64_t currentTime = time_us_64();
+
+			receiveLatency.add(currentTime - frameHeaderTime);
+
+			uint32_t irqState = save_and_disable_interrupts();
+
+			#if defined(STREAMING_RENDER)
+				if (sentHeaderTime == frameHeaderTime && sentValidTime == 0)
+				{
+					// the frame was streamed while it was arriving: its transfer could be already finished
+					if (streamedEnd != 0)
+					{
+						addFrameLatency(sentHeaderTime, currentTime, streamedStart, streamedEnd);
+						sentHeaderTime = 0;
+					}
+					else
+						sentValidTime = currentTime;
+
+					restore_interrupts(irqState);
+					return;
+				}
+			#endif
+
+			pendingHeaderTime = frameHeaderTime;
+			pendingValidTime = currentTime;
+			restore_interrupts(irqState);
+		}
+
+		/**
+		 * @brief The renderer has submitted the frame to the LED driver: the waiting frame if there is any,
+		 *        otherwise a repeated frame that is not counted
+		 *
+		 */
+		inline void markFrameSubmitted()
+		{
+			uint32_t irqState = save_and_disable_interrupts();
+			sentHeaderTime = pendingHeaderTime;
+			sentValidTime = pendingValidTime;
+			pendingHeaderTime = 0;
+			pendingValidTime = 0;
+			restore_interrupts(irqState);
+		}
+
+		#if defined(STREAMING_RENDER)
+			/**
+			 * @brief The frame that is still arriving has started streaming
+			 *
+			 */
+			inline void markFrameStreamed()
+			{
+				uint32_t irqState = save_and_disable_interrupts();
+				sentHeaderTime = frameHeaderTime;
+				sentValidTime = 0;
+				streamedEnd = 0;
+				restore_interrupts(irqState);
+			}
+		#endif
+
+		/**
+		 * @brief All lanes have sent the submitted frame (from the DMA IRQ)
+		 *
+		 * @param start the first DMA transfer has started (after the latch time)
+		 * @param end the last DMA transfer has finished
+		 */
+		inline void addFrameTransfer(uint64_t start, uint64_t end)
+		{
+			if (sentHeaderTime == 0)
+				return;
+
+			#if defined(STREAMING_RENDER)
+				if (sentValidTime == 0)
+				{
+					streamedStart = start;
+					streamedEnd = end;
+					return;
+				}
+			#endif
+
+			addFrameLatency(sentHeaderTime, sentValidTime, start, end);
+			sentHeaderTime = 0;
+		}
+
+		/**
+		 * @brief Latency histograms of the frames. Receive: header to validation, queue: validation to DMA start,
+		 *        transfer: DMA start to completion, total: header to completion
+		 *
+		 */
+		inline const LatencyHistogram& getReceiveLatency()
+		{
+			return receiveLatency;
+		}
+
+		inline const LatencyHistogram& getQueueLatency()
+		{
+			return queueLatency;
+		}
+
+		inline const LatencyHistogram& getTransferLatency()
+		{
+			return transferLatency;
+		}
+
+		inline const LatencyHistogram& getTotalLatency()
+		{
+			return totalLatency;
+		}
+
+		/**
+		 * @brief The parser has discarded bytes while searching for the frame header: starts the resync
+		 *
+		 * @param bytes
+		 */
+		inline void addResyncDiscarded(uint32_t bytes)
+		{
+			if (!resyncing)
+			{
+				resyncing = true;
+				resyncStartTime = time_us_64();
+				resyncBytes = 0;
+			}
+
+			resyncBytes += bytes;
+		}
+
+		/**
+		 * @brief The frame header has passed the CRC: finishes the resync
+		 *
+		 */
+		inline void markHeaderSynced()
+		{
+			if (!resyncing)
+				return;
+
+			uint32_t time = (uint32_t)std::min(time_us_64() - resyncStartTime, (uint64_t)UINT32_MAX);
+
+			resyncing = false;
+			resyncs++;
+			resyncTotalBytes += resyncBytes;
+			resyncMaxBytes = std::max(resyncMaxBytes, resyncBytes);
+			resyncTotalTime += time;
+			resyncMaxTime = std::max(resyncMaxTime, time);
+		}
+
+		inline uint32_t getResyncs()
+		{
+			return resyncs;
+		}
+
+		inline uint32_t getResyncBytes()
+		{
+			return (resyncs > 0) ? resyncTotalBytes / resyncs : 0;
+		}
+
+		inline uint32_t getResyncMaxBytes()
+		{
+			return resyncMaxBytes;
+		}
+
+		inline uint32_t getResyncTime()
+		{
+			return (resyncs > 0) ? (uint32_t)(resyncTotalTime / resyncs) : 0;
+		}
+
+		inline uint32_t getResyncMaxTime()
+		{
+			return resyncMaxTime;
+		}
+
+		/**
+		 * @brief core0 has read the USB data after the wake-up (core0 is the only writer of the USB counters)
+		 *
+		 * @param bytes
+		 * @param stalled the CDC receive buffer was full: the USB transfers were held back
+		 */
+		inline void addUsbReceive(uint32_t bytes, bool stalled)
+		{
+			uint32_t maxBytes = usbMaxBytes.load(std::memory_order_relaxed);
+			uint32_t resetRequest = usbMaxResetRequest.load(std::memory_order_acquire);
+
+			if (resetRequest != usbMaxResetDone.load(std::memory_order_relaxed))
+				maxBytes = 0;
+
+			usbReads.store(usbReads.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			usbBytes.store(usbBytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+			usbMaxBytes.store(std::max(maxBytes, bytes), std::memory_order_relaxed);
+			usbMaxResetDone.store(resetRequest, std::memory_order_release);
+
+			if (stalled)
+				addUsbStall();
+		}
+
+		/**
+		 * @brief core0 has left the USB data in the CDC receive buffer: the ring buffer is full
+		 *
+		 */
+		inline void addUsbStall()
+		{
+			usbStalls.store(usbStalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		inline uint32_t getUsbReads()
+		{
+			return usbReads.load(std::memory_order_relaxed) - usbReadsBase;
+		}
+
+		inline uint32_t getUsbBytes()
+		{
+			return usbBytes.load(std::memory_order_relaxed) - usbBytesBase;
+		}
+
+		inline uint32_t getUsbBytesPerRead()
+		{
+			uint32_t reads = getUsbReads();
+
+			return (reads > 0) ? getUsbBytes() / reads : 0;
+		}
+
+		inline uint32_t getUsbMaxBytesPerRead()
+		{
+			// core0 hasn't read anything since the reset yet
+			if (usbMaxResetDone.load(std::memory_order_acquire) != usbMaxResetRequest.load(std::memory_order_relaxed))
+				return 0;
+
+			return usbMaxBytes.load(std::memory_order_relaxed);
+		}
+
+		inline uint32_t getUsbStalls()
+		{
+			return usbStalls.load(std::memory_order_relaxed) - usbStallsBase;
+		}
+
+		/**
+		 * @brief Set the time of the frame copy that the LED driver saves by swapping its buffers
+		 *
+		 * @param saving
+		 */
+		inline void setBufferSwapSaving(uint32_t saving)
+		{
+			bufferSwapSaving = saving;
+		}
+
+		/**
+		 * @brief Set the state of the receive ring buffer
+		 *
+		 * @param size capacity in bytes
+		 * @param dropped bytes that didn't fit since the start
+		 */
+		inline void setRingState(uint32_t size, uint32_t dropped)
+		{
+			ringSize = size;
+			ringDropped = dropped;
+		}
+
 		/**
 		 * @brief Get number of correctly received frames
 		 *
@@ -108,30 +679,287 @@ class
 		}
 
 		/**
-		 * @brief Print last saved statistics to the serial port
+		 * @brief Queue last saved statistics for the serial port: only the values are saved here,
+		 *        core0 formats the lines (formatReport) when it sends the deferred output
 		 *
 		 * @param curTime
 		 * @param taskHandle
 		 */
 		void print(unsigned long curTime, TaskHandle_t taskHandle1, TaskHandle_t taskHandle2)
 		{
-			char output[128];
-
 			startTime = curTime;
 			goodFrames = 0;
 			totalFrames = 0;
 			showFrames = 0;
 
-			snprintf(output, sizeof(output), "HyperHDR frames: %u (FPS), receiv.: %u, good: %u, incompl.: %u, mem1: %i, mem2: %i, heap: %zu\r\n",
-						finalShowFrames, finalTotalFrames,finalGoodFrames,(finalTotalFrames - finalGoodFrames),
-						(taskHandle1 != nullptr) ? uxTaskGetStackHighWaterMark(taskHandle1) : 0,
-						(taskHandle2 != nullptr) ? uxTaskGetStackHighWaterMark(taskHandle2) : 0,
-						xPortGetFreeHeapSize());
-			printf(output);
+			if (!logger.reserveReport())
+				return;
+
+			report.showFrames = finalShowFrames;
+			report.totalFrames = finalTotalFrames;
+			report.goodFrames = finalGoodFrames;
+			report.stack1 = (taskHandle1 != nullptr) ? uxTaskGetStackHighWaterMark(taskHandle1) : 0;
+			report.stack2 = (taskHandle2 != nullptr) ? uxTaskGetStackHighWaterMark(taskHandle2) : 0;
+			report.heap = xPortGetFreeHeapSize();
+			report.bufferSwapSaving = bufferSwapSaving;
+
+			uint64_t latchReclaimed;
+			DmaClient::getLatchStatistics(report.latchDeferred, latchReclaimed);
+			report.latchReclaimed = latchReclaimed / 1000;
+
+			#if defined(STREAMING_RENDER)
+				report.streamedFrames = streamedFrames;
+				report.streamUnderruns = streamUnderruns;
+				report.streamRepairs = streamRepairs;
+				report.streamLatched = streamLatched;
+			#endif
+
+			#if defined(DITHERING_RENDER)
+				report.ditheredFrames = ditheredFrames;
+			#endif
+
+			#if defined(RENDER_SCHEDULER)
+				report.droppedLateFrames = droppedLateFrames;
+			#endif
+
+			report.usbReads = getUsbReads();
+			report.usbBytesPerRead = getUsbBytesPerRead();
+			report.usbMaxBytes = getUsbMaxBytesPerRead();
+			report.usbStalls = getUsbStalls();
+			report.ringSize = ringSize;
+			report.ringDropped = ringDropped;
+			report.resyncs = resyncs;
+			report.resyncBytes = getResyncBytes();
+			report.resyncMaxBytes = resyncMaxBytes;
+			report.resyncTime = getResyncTime();
+			report.resyncMaxTime = resyncMaxTime;
+			report.logDropped = logger.getDropped();
+			report.logDroppedReports = logger.getDroppedReports();
+			std::copy(std::begin(wakeUpLatency), std::end(wakeUpLatency), std::begin(report.wakeUpLatency));
+			report.wakeUpLatencyMax = wakeUpLatencyMax;
+
+			int index = 0;
+			for (auto histogram : { &receiveLatency, &queueLatency, &transferLatency, &totalLatency })
+			{
+				// the DMA IRQ updates them
+				uint32_t irqState = save_and_disable_interrupts();
+				report.latency[index][0] = histogram->getPercentile(50);
+				report.latency[index][1] = histogram->getPercentile(95);
+				report.latency[index][2] = histogram->getPercentile(99);
+				report.latency[index][3] = histogram->getMax();
+				report.latency[index][4] = histogram->getSamples();
+				restore_interrupts(irqState);
+				index++;
+			}
+
+			report.lutEnabled = colorLut.isEnabled();
+			report.lutUploads = colorLut.getUploads();
 
 			#if defined(NEOPIXEL_RGBW)
-				calibrationConfig.printCalibration();
+				calibrationConfig.getParams(report.gain, report.red, report.green, report.blue);
+			#endif
+
+			logger.writeReport(formatStatisticsReport);
+		}
+
+		/**
+		 * @brief core0: format the line of the queued text report
+		 *
+		 * @param line
+		 * @param output
+		 * @param size
+		 * @return int the length, 0: the line is skipped, -1: no more lines
+		 */
+		int formatReport(int line, char* output, int size)
+		{
+			static const char* const latencyNames[] = { "receive", "queue", "transfer", "total" };
+			int length = 0;
+
+			switch (line)
+			{
+				case 0:
+					length = snprintf(output, size, "HyperHDR frames: %u (FPS), receiv.: %u, good: %u, incompl.: %u, mem1: %i, mem2: %i, heap: %zu\r\n",
+								report.showFrames, report.totalFrames, report.goodFrames, (report.totalFrames - report.goodFrames),
+								report.stack1, report.stack2, report.heap);
+					break;
+
+				case 1:
+					length = snprintf(output, size, "Render => buffer swap saved: ~%u us/frame (estimated)\r\n", (unsigned int)report.bufferSwapSaving);
+					break;
+
+				case 2:
+					length = snprintf(output, size, "Latch => deferred starts: %u, reclaimed: %u ms\r\n",
+								(unsigned int)report.latchDeferred, (unsigned int)report.latchReclaimed);
+					break;
+
+				#if defined(STREAMING_RENDER)
+					case 3:
+						length = snprintf(output, size, "Streaming => frames: %u, underruns: %u, repaired: %u, latched: %u\r\n",
+									(unsigned int)report.streamedFrames, (unsigned int)report.streamUnderruns, (unsigned int)report.streamRepairs,
+									(unsigned int)report.streamLatched);
+						break;
+				#endif
+
+				#if defined(DITHERING_RENDER)
+					case 4:
+						length = snprintf(output, size, "Dithering => repeated frames: %u\r\n", (unsigned int)report.ditheredFrames);
+						break;
+				#endif
+
+				#if defined(RENDER_SCHEDULER)
+					case 5:
+						length = snprintf(output, size, "Scheduler => dropped late frames: %u\r\n", (unsigned int)report.droppedLateFrames);
+						break;
+				#endif
+
+				case 6:
+					length = snprintf(output, size, "USB => reads: %u, bytes/read: %u, max: %u, stalls: %u\r\n",
+								(unsigned int)report.usbReads, (unsigned int)report.usbBytesPerRead, (unsigned int)report.usbMaxBytes,
+								(unsigned int)report.usbStalls);
+					break;
+
+				case 7:
+					length = snprintf(output, size, "Ring => size: %u, dropped bytes: %u\r\n", (unsigned int)report.ringSize, (unsigned int)report.ringDropped);
+					break;
+
+				case 8:
+					length = snprintf(output, size, "Resync => count: %u, bytes/resync: %u, max: %u, time/resync: %u us, max: %u us\r\n",
+								(unsigned int)report.resyncs, (unsigned int)report.resyncBytes, (unsigned int)report.resyncMaxBytes,
+								(unsigned int)report.resyncTime, (unsigned int)report.resyncMaxTime);
+					break;
+
+				case 9:
+					length = snprintf(output, size, "Log => dropped bytes: %u, reports: %u\r\n",
+								(unsigned int)report.logDropped, (unsigned int)report.logDroppedReports);
+					break;
+
+				case 10:
+					length = snprintf(output, size, "Wake-up => max: %u us", (unsigned int)report.wakeUpLatencyMax);
+					for (int i = 0; i < WAKE_UP_LATENCY_BUCKETS && length < size; i++)
+						if (report.wakeUpLatency[i] > 0)
+							length += snprintf(output + length, size - length, (i + 1 < WAKE_UP_LATENCY_BUCKETS) ? ", <%u: %u" : ", >=%u: %u",
+												(i + 1 < WAKE_UP_LATENCY_BUCKETS) ? 2u << i : 1u << i, (unsigned int)report.wakeUpLatency[i]);
+					if (length < size)
+						length += snprintf(output + length, size - length, "\r\n");
+					break;
+
+				case 11:
+				case 12:
+				case 13:
+				case 14:
+				{
+					const uint32_t* latency = report.latency[line - 11];
+					length = snprintf(output, size, "Latency %s => p50: %u, p95: %u, p99: %u, max: %u us, frames: %u\r\n", latencyNames[line - 11],
+								(unsigned int)latency[0], (unsigned int)latency[1], (unsigned int)latency[2], (unsigned int)latency[3], (unsigned int)latency[4]);
+					break;
+				}
+
+				case 15:
+					length = snprintf(output, size, "LUT => %s, uploads: %u\r\n", (report.lutEnabled) ? "enabled" : "identity", (unsigned int)report.lutUploads);
+					break;
+
+				#if defined(NEOPIXEL_RGBW)
+					case 16:
+						length = snprintf(output, size, "RGBW => Gain: %i/255, red: %i, green: %i, blue: %i\r\n", report.gain, report.red, report.green, report.blue);
+						break;
+				#endif
+
+				default:
+					return (line < 17) ? 0 : -1;
+			}
+
+			return std::min(length, size - 1);
+		}
+
+		/**
+		 * @brief Send last saved statistics as the binary telemetry record (the same values as the text report).
+		 *        Payload version 3:
+		 *        frames: shown, received, good (2 bytes each), mem1, mem2 (2 bytes each), heap,
+		 *        buffer swap saving [us] (estimated from the frame size), latch: deferred starts, reclaimed [ms],
+		 *        streaming: frames, underruns, repaired, dithering: repeated frames, scheduler: dropped late frames,
+		 *        USB: reads, bytes, max bytes per read, stalls, ring: size, dropped bytes, wake-up: count, max [us],
+		 *        latency (receive, queue, transfer, total): p50, p95, p99, max [us] and frames, log: dropped bytes,
+		 *        resync: count, discarded bytes per resync, max, time per resync [us], max [us], streaming: latched frames.
+		 *        All fields have 4 bytes unless noted, the counters of the disabled features are 0
+		 *
+		 * @param taskHandle1
+		 * @param taskHandle2
+		 */
+		void sendRecord(TaskHandle_t taskHandle1, TaskHandle_t taskHandle2)
+		{
+			TelemetryRecord record(TELEMETRY_STATISTICS, TELEMETRY_STATISTICS_VERSION);
+
+			record.put16(finalShowFrames);
+			record.put16(finalTotalFrames);
+			record.put16(finalGoodFrames);
+			record.put16((taskHandle1 != nullptr) ? uxTaskGetStackHighWaterMark(taskHandle1) : 0);
+			record.put16((taskHandle2 != nullptr) ? uxTaskGetStackHighWaterMark(taskHandle2) : 0);
+			record.put32(xPortGetFreeHeapSize());
+			record.put32(bufferSwapSaving);
+
+			uint32_t latchDeferred;
+			uint64_t latchReclaimed;
+			DmaClient::getLatchStatistics(latchDeferred, latchReclaimed);
+			record.put32(latchDeferred);
+			record.put32(latchReclaimed / 1000);
+
+			#if defined(STREAMING_RENDER)
+				record.put32(streamedFrames);
+				record.put32(streamUnderruns);
+				record.put32(streamRepairs);
+			#else
+				record.put32(0);
+				record.put32(0);
+				record.put32(0);
+			#endif
+
+			#if defined(DITHERING_RENDER)
+				record.put32(ditheredFrames);
+			#else
+				record.put32(0);
+			#endif
+
+			#if defined(RENDER_SCHEDULER)
+				record.put32(droppedLateFrames);
+			#else
+				record.put32(0);
 			#endif
+
+			record.put32(getUsbReads());
+			record.put32(getUsbBytes());
+			record.put32(getUsbMaxBytesPerRead());
+			record.put32(getUsbStalls());
+			record.put32(ringSize);
+			record.put32(ringDropped);
+			record.put32(wakeUps);
+			record.put32(wakeUpLatencyMax);
+
+			for (auto histogram : { &receiveLatency, &queueLatency, &transferLatency, &totalLatency })
+			{
+				// the DMA IRQ updates them
+				uint32_t irqState = save_and_disable_interrupts();
+				record.put32(histogram->getPercentile(50));
+				record.put32(histogram->getPercentile(95));
+				record.put32(histogram->getPercentile(99));
+				record.put32(histogram->getMax());
+				record.put32(histogram->getSamples());
+				restore_interrupts(irqState);
+			}
+
+			record.put32(logger.getDropped());
+			record.put32(resyncs);
+			record.put32(getResyncBytes());
+			record.put32(resyncMaxBytes);
+			record.put32(getResyncTime());
+			record.put32(resyncMaxTime);
+
+			#if defined(STREAMING_RENDER)
+				record.put32(streamLatched);
+			#else
+				record.put32(0);
+			#endif
+
+			record.send();
 		}
 
 		/**
@@ -146,6 +974,47 @@ class
 			finalGoodFrames = 0;
 			finalTotalFrames = 0;
 
+			DmaClient::resetLatchStatistics();
+
+			std::fill(std::begin(wakeUpLatency), std::end(wakeUpLatency), 0);
+			wakeUpLatencyMax = 0;
+			wakeUps = 0;
+
+			uint32_t irqState = save_and_disable_interrupts();
+			pendingHeaderTime = 0;
+			pendingValidTime = 0;
+			sentHeaderTime = 0;
+			for (auto histogram : { &receiveLatency, &queueLatency, &transferLatency, &totalLatency })
+				histogram->reset();
+			restore_interrupts(irqState);
+
+			// core0 keeps counting: only the start of the new period is saved
+			usbReadsBase = usbReads.load(std::memory_order_relaxed);
+			usbBytesBase = usbBytes.load(std::memory_order_relaxed);
+			usbStallsBase = usbStalls.load(std::memory_order_relaxed);
+			usbMaxResetRequest.store(usbMaxResetRequest.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+			resyncs = 0;
+			resyncTotalBytes = 0;
+			resyncMaxBytes = 0;
+			resyncTotalTime = 0;
+			resyncMaxTime = 0;
+
+			#if defined(STREAMING_RENDER)
+				streamedFrames = 0;
+				streamUnderruns = 0;
+				streamRepairs = 0;
+				streamLatched = 0;
+			#endif
+
+			#if defined(DITHERING_RENDER)
+				ditheredFrames = 0;
+			#endif
+
+			#if defined(RENDER_SCHEDULER)
+				droppedLateFrames = 0;
+			#endif
+
 			goodFrames = 0;
 			totalFrames = 0;
 			showFrames = 0;
@@ -163,4 +1032,13 @@ class
 
 } statistics;
 
+/**
+ * @brief core0: the lines of the text report queued by statistics.print
+ *
+ */
+inline int formatStatisticsReport(int line, char* output, int size)
+{
+	return statistics.formatReport(line, output, size);
+}
+
 #endif
\ No newline at end of file
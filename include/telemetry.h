@@ -0,0 +1,125 @@
+/* telemetry.h
+*
+*  MIT License
+*
+*  Copyright (c) 2023-2026 awawa-dev
+*
+*  https://github.com/awawa-dev/HyperSerialPico
+
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "logger.h"
+
+// binary telemetry record, all numbers little-endian:
+// 'A' 'w' 't', type, version, payload length (2 bytes), payload, Fletcher checksums of the type...payload (2 bytes)
+#define TELEMETRY_HEADER_SIZE 7
+#define TELEMETRY_MAX_PAYLOAD 192
+#define TELEMETRY_PROFILE 0x01
+#define TELEMETRY_STATISTICS 0x02
+
+class TelemetryRecord
+{
+	uint8_t data[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + 2];
+	int length = TELEMETRY_HEADER_SIZE;
+	bool overflow = false;
+
+	public:
+		TelemetryRecord(uint8_t type, uint8_t version)
+		{
+			data[0] = 'A';
+			data[1] = 'w';
+			data[2] = 't';
+			data[3] = type;
+			data[4] = version;
+		}
+
+		/**
+		 * @brief Append the number to the payload (little-endian).
+		 *        If it doesn't fit, the record is marked as broken and send() refuses it
+		 *
+		 * @param value
+		 * @param bytes
+		 */
+		void put(uint64_t value, int bytes)
+		{
+			if (length + bytes > TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD)
+			{
+				overflow = true;
+				return;
+			}
+
+			for (int i = 0; i < bytes; i++)
+				data[length++] = (uint8_t)(value >> (8 * i));
+		}
+
+		inline void put8(uint8_t value)
+		{
+			put(value, 1);
+		}
+
+		inline void put16(uint16_t value)
+		{
+			put(value, 2);
+		}
+
+		inline void put32(uint32_t value)
+		{
+			put(value, 4);
+		}
+
+		inline void put64(uint64_t value)
+		{
+			put(value, 8);
+		}
+
+		/**
+		 * @brief Complete the record and queue it to the deferred output
+		 *
+		 * @return false if it was dropped (the payload overflowed or the output queue is full)
+		 */
+		bool send()
+		{
+			if (overflow)
+				return false;
+
+			uint16_t fletcher1 = 0, fletcher2 = 0;
+			int payload = length - TELEMETRY_HEADER_SIZE;
+
+			data[5] = payload & 0xff;
+			data[6] = payload >> 8;
+
+			for (int i = 3; i < length; i++)
+			{
+				fletcher1 = (fletcher1 + data[i]) % 255;
+				fletcher2 = (fletcher2 + fletcher1) % 255;
+			}
+
+			data[length++] = fletcher1;
+			data[length++] = fletcher2;
+
+			return logger.write(data, length);
+		}
+};
+
+#endif
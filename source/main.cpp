@@ -36,6 +36,7 @@
 #include "pico/stdlib.h"
 #include "pico/stdio.h"
 #include "pico/stdio_usb.h"
+#include "tusb.h"
 #include "pico/multicore.h"
 #include "pico/sem.h"
 #include "leds.h"
@@ -50,6 +51,9 @@
 #define VAR_NAME_VALUE(var) #var " = " _XSTR(var)
 #define _XSTR2(x,y) _STR(x) _STR(y)
 #define VAR_NAME_VALUE2(var) #var " = " _XSTR2(var)
+#define _STRV(...) #__VA_ARGS__
+#define _XSTRV(...) _STRV(__VA_ARGS__)
+#define VAR_NAME_VALUES(var) #var " = " _XSTRV(var)
 
 #if defined(BOOT_WORKAROUND) && defined(PICO_XOSC_STARTUP_DELAY_MULTIPLIER)
 	#pragma message("Enabling boot workaround")
@@ -73,18 +77,9 @@
 	#pragma message(VAR_NAME_VALUE(SPILED_WS2801))
 #endif
 
-#ifdef NEOPIXEL_RGBW
-	#define LED_DRIVER sk6812
-#elif NEOPIXEL_RGB
-	#define LED_DRIVER ws2812
-#endif
+#include "leddriver.h"
 
-#ifdef SPILED_APA102
-	#define LED_DRIVER apa102
-	#pragma message(VAR_NAME_VALUE(SPI_INTERFACE))
-#endif
-#ifdef SPILED_WS2801
-	#define LED_DRIVER ws2801
+#if defined(SPILED_APA102) || defined(SPILED_WS2801)
 	#pragma message(VAR_NAME_VALUE(SPI_INTERFACE))
 #endif
 
@@ -93,46 +88,95 @@
 	#pragma message(VAR_NAME_VALUE(CLOCK_PIN))
 #endif
 
-#if defined(SECOND_SEGMENT_START_INDEX)
+#if defined(SEGMENT_INDEXES)
 	#pragma message("Using parallel mode for segments")
-
-	#ifdef NEOPIXEL_RGBW
-			#undef LED_DRIVER
-			#define LED_DRIVER sk6812p
-			#define LED_DRIVER2 sk6812p
-	#elif NEOPIXEL_RGB
-			#undef LED_DRIVER
-			#define LED_DRIVER ws2812p
-			#define LED_DRIVER2 ws2812p
-	#else
-		#error "Parallel mode is unsupportd for selected LEDs configuration"
-	#endif
-
 	#pragma message(VAR_NAME_VALUE(LED_DRIVER))
-	#pragma message(VAR_NAME_VALUE(SECOND_SEGMENT_START_INDEX))
-	#pragma message(VAR_NAME_VALUE(LED_DRIVER2))
-	#pragma message(VAR_NAME_VALUE(SECOND_SEGMENT_REVERSED))
+	#pragma message(VAR_NAME_VALUES(SEGMENT_INDEXES))
+	#ifdef SEGMENTS_REVERSED
+		#pragma message(VAR_NAME_VALUES(SEGMENTS_REVERSED))
+	#endif
+	#ifdef SEGMENTS_INTERLEAVED
+		#pragma message(VAR_NAME_VALUE(SEGMENTS_INTERLEAVED))
+	#endif
+	#ifdef SEGMENTS_INDEPENDENT
+		#pragma message(VAR_NAME_VALUE(SEGMENTS_INDEPENDENT))
+	#endif
 #else
 	#pragma message(VAR_NAME_VALUE(LED_DRIVER))
+#endif
+
+#if defined(STREAMING_RENDER)
+	#pragma message(VAR_NAME_VALUE(STREAMING_RENDER))
+#endif
+
+#if defined(INTERPOLATION_RENDER)
+	#pragma message(VAR_NAME_VALUE(INTERPOLATION_RENDER))
+#endif
+
+#if defined(DITHERING_RENDER)
+	#pragma message("Dithering render is enabled")
+#endif
+
+#if defined(RENDER_SCHEDULER)
+	#pragma message("Render scheduler is enabled")
+#endif
+
+#if defined(FRAME_PACING)
+	#pragma message(VAR_NAME_VALUE(FRAME_PACING))
+#endif
 
-	typedef LedDriver LED_DRIVER2;
+#if defined(HYPERSERIAL_PROFILE)
+	#pragma message("Profiling of the core1 stages is enabled")
 #endif
 
 /////////////////////////////////////////////////////////////////////////
 #define delay(x) sleep_ms(x)
-#define yield() busy_wait_us(100)
 #define millis xTaskGetTickCount
 
 #include "main.h"
 
 static void core1()
 {
+    #if defined(HYPERSERIAL_PROFILE)
+        profiler.begin();
+    #endif
+
     for( ;; )
     {
-        if (sem_acquire_timeout_us(&base.serialSemaphore, portMAX_DELAY))
-        {
+        #if defined(INTERPOLATION_RENDER) || defined(DITHERING_RENDER)
+            // wake up periodically to render the interpolated or dithered frames also when no data comes
+            base.waitForDoorbell(RENDER_TICK_PERIOD);
             processData();
-        }
+        #else
+            if (base.waitForDoorbell(0))
+            {
+                processData();
+            }
+        #endif
+    }
+}
+
+/**
+ * @brief Send the deferred output of core1 (statistics, telemetry) as far as the USB accepts it without waiting
+ *
+ */
+static void drainLogger()
+{
+    uint32_t length;
+    const uint8_t* data;
+
+    while ((data = logger.getPending(length)), length > 0)
+    {
+        // the USB task (low priority IRQ on this core) can't interleave
+        uint32_t irqState = save_and_disable_interrupts();
+        uint32_t sent = tud_cdc_write(data, length);
+        tud_cdc_write_flush();
+        restore_interrupts(irqState);
+
+        if (sent == 0)
+            break;
+
+        logger.consume(sent);
     }
 }
 
@@ -140,26 +184,58 @@ static void core0( void *pvParameters )
 {
     for( ;; )
     {
-        if (sem_acquire_timeout_us(&base.receiverSemaphore, portMAX_DELAY))
+        // wakes up also periodically to send the deferred output (core1 doesn't signal it)
+        // and to retry the data left in the CDC FIFO when the ring buffer was full
+        if (sem_acquire_timeout_us(&base.receiverSemaphore, LOG_DRAIN_PERIOD) || tud_cdc_available() > 0)
         {
-            int wanted, received;
-            do
+            // no room for the next USB packet: the host had to wait for us
+            bool stalled = (tud_cdc_available() > CFG_TUD_CDC_RX_BUFSIZE - CFG_TUD_CDC_EP_BUFSIZE);
+            uint32_t received = 0, available;
+
+            // read the TinyUSB CDC FIFO straight to the ring buffer: everything up to the end of the ring at once.
+            // The interrupts are disabled so the USB task (low priority IRQ on this core) can't interleave
+            while ((available = tud_cdc_available()) > 0)
             {
-                wanted = std::min(MAX_BUFFER - base.queueEnd, MAX_BUFFER - 1);
-                received = stdio_usb.in_chars((char*)(&(base.buffer[base.queueEnd])), wanted);
-                if (received > 0)
+                uint32_t space, count;
+                uint8_t* target = base.ring.getWriteSpan(space);
+
+                // the parser is behind by the whole buffer: the data stays in the CDC FIFO,
+                // so the endpoint NAKs the host until the next wake-up finds some room
+                if (space == 0)
                 {
-                    base.queueEnd = (base.queueEnd + received) % (MAX_BUFFER);
+                    stalled = true;
+                    break;
                 }
-            }while(wanted == received);
 
-            sem_release(&base.serialSemaphore);
+                uint32_t irqState = save_and_disable_interrupts();
+                count = tud_cdc_read(target, std::min(available, space));
+                restore_interrupts(irqState);
+
+                if (count == 0)
+                    break;
+
+                base.ring.commitWrite(count);
+                received += count;
+            }
+
+            if (received > 0)
+            {
+                statistics.addUsbReceive(received, stalled);
+                base.ringDoorbell();
+            }
+            else if (stalled)
+                statistics.addUsbStall();
         }
+
+        // idle: no more incoming data
+        if (tud_cdc_available() == 0)
+            drainLogger();
     }
 }
 
 static void serialEvent(void *)
 {
+    base.onUsbCallback();
     sem_release(&base.receiverSemaphore);
 }
 
@@ -167,8 +243,6 @@ int main(void)
 {
     stdio_init_all();
 
-    sem_init(&base.serialSemaphore, 0, 1);
-
     sem_init(&base.receiverSemaphore, 0, 1);
 
     multicore_launch_core1(core1);